@@ -6,6 +6,7 @@
  */
 
 #include "bitops.h"
+#include "register.h"
 
 #include <gtest/gtest.h>
 
@@ -301,6 +302,65 @@ TEST(Range, bitmask)
     EXPECT_EQ(rng::endBit, 19);
 }
 
+namespace
+{
+struct TestReg : bitops::Register<uint32_t, 0x40001000u, 0x0300u>
+{
+    enum class Mode : uint32_t
+    {
+        idle = 0,
+        run = 2,
+    };
+    using EN = bitops::RegField<TestReg, bool, 0, 1>;
+    using MODE = bitops::RegField<TestReg, Mode, 8, 2>;
+    using FLAG =
+        bitops::RegField<TestReg, bool, 31, 1, bitops::access::ReadOnly>;
+};
+} // namespace
+
+TEST(Register, regField)
+{
+    static_assert(TestReg::address() == 0x40001000u, "");
+    static_assert(TestReg::resetValue() == 0x0300u, "");
+    static_assert(TestReg::EN::Access::writable, "");
+    static_assert(!TestReg::FLAG::Access::writable, "");
+    static_assert(TestReg::FLAG::Access::readable, "");
+
+    auto wu = bitops::set<TestReg::EN>() %
+              bitops::value<TestReg::MODE>(TestReg::Mode::run);
+    EXPECT_EQ(wu.toClear, 0x300u);
+    EXPECT_EQ(wu.toSet, 0x201u);
+
+    uint32_t val = TestReg::resetValue();
+    val %= wu;
+    EXPECT_EQ(val, 0x201u);
+    EXPECT_EQ(bitops::read<TestReg::MODE::Field>(val), TestReg::Mode::run);
+}
+
+TEST(bitops, reverseBits_byteSwap)
+{
+    static_assert(bitops::byteSwap(uint16_t(0x1234)) == 0x3412, "");
+    static_assert(bitops::byteSwap(0x12345678u) == 0x78563412u, "");
+    static_assert(bitops::reverseBits(uint8_t(0x01)) == 0x80, "");
+    static_assert(bitops::reverseBits(uint16_t(0x1235)) == 0xac48, "");
+    static_assert(bitops::reverseBits(1ull) == 1ull << 63, "");
+    EXPECT_EQ(bitops::reverseBits(0x80000001u), 0x80000001u);
+    EXPECT_EQ(bitops::reverseBits(0x0000f00du), 0xb00f0000u);
+}
+
+TEST(bitops, signed_storage)
+{
+    // No sign extension when widened for the builtins.
+    static_assert(bitops::popCount(int8_t(-1)) == 8, "");
+    static_assert(bitops::popCount(int16_t(-1)) == 16, "");
+    static_assert(bitops::popCount(-1) == 32, "");
+    static_assert(bitops::popCount(int64_t(-1)) == 64, "");
+    static_assert(bitops::countTrailingZeros(int8_t(-128)) == 7, "");
+    static_assert(bitops::reverseBits(int8_t(1)) == int8_t(-128), "");
+    static_assert(bitops::reverseBits(int8_t(-128)) == 1, "");
+    static_assert(bitops::reverseBits(int16_t(-2)) == int16_t(0x7fff), "");
+}
+
 int
 main(int argc, char** argv)
 {
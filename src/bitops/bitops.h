@@ -3,6 +3,7 @@
 #include <climits>
 #include <cstdint>
 #include <limits>
+#include <type_traits>
 
 /**
  * Bitops. Collects a number of operations to manipulate bit fields
@@ -119,6 +120,86 @@ maskWidth(Storage mask)
     return maskEndBit(mask) - maskLowBit(mask);
 };
 
+namespace details
+{
+// Value as the unsigned type of the same size, so signed values are not
+// sign extended when widened.
+template <typename Storage>
+constexpr typename std::make_unsigned<Storage>::type
+toUnsigned(Storage value)
+{
+    return static_cast<typename std::make_unsigned<Storage>::type>(value);
+}
+} // namespace details
+
+/**
+ * Return the number of bits set to '1' in value. Maps to the compiler
+ * builtin to get a single instruction where the target has one.
+ */
+template <typename Storage>
+constexpr int
+popCount(Storage value)
+{
+    static_assert(sizeof(Storage) <= sizeof(unsigned long long), "");
+    return sizeof(Storage) <= sizeof(unsigned)
+               ? __builtin_popcount(
+                     static_cast<unsigned>(details::toUnsigned(value)))
+               : __builtin_popcountll(static_cast<unsigned long long>(
+                     details::toUnsigned(value)));
+}
+
+/**
+ * Return the bit number of the lowest '1' bit in value.
+ * Precondition: value != 0.
+ */
+template <typename Storage>
+constexpr int
+countTrailingZeros(Storage value)
+{
+    static_assert(sizeof(Storage) <= sizeof(unsigned long long), "");
+    return sizeof(Storage) <= sizeof(unsigned)
+               ? __builtin_ctz(
+                     static_cast<unsigned>(details::toUnsigned(value)))
+               : __builtin_ctzll(static_cast<unsigned long long>(
+                     details::toUnsigned(value)));
+}
+
+/**
+ * Return value with the byte order reversed.
+ */
+template <typename Storage>
+constexpr Storage
+byteSwap(Storage value)
+{
+    static_assert(sizeof(Storage) <= 8, "");
+    return sizeof(Storage) == 1
+               ? value
+               : sizeof(Storage) == 2
+                     ? static_cast<Storage>(__builtin_bswap16(value))
+                     : sizeof(Storage) == 4
+                           ? static_cast<Storage>(__builtin_bswap32(value))
+                           : static_cast<Storage>(__builtin_bswap64(value));
+}
+
+/**
+ * Return value with the bit order reversed, bit 0 becomes the highest bit.
+ */
+template <typename Storage>
+constexpr Storage
+reverseBits(Storage value)
+{
+    using U = unsigned long long;
+    const U m1 = 0x5555555555555555ull;
+    const U m2 = 0x3333333333333333ull;
+    const U m4 = 0x0f0f0f0f0f0f0f0full;
+    U v = static_cast<U>(details::toUnsigned(value));
+    // Reverse bits within each byte, then reverse the bytes.
+    v = ((v >> 1) & m1) | ((v & m1) << 1);
+    v = ((v >> 2) & m2) | ((v & m2) << 2);
+    v = ((v >> 4) & m4) | ((v & m4) << 4);
+    return byteSwap(static_cast<Storage>(v));
+}
+
 /**
  * Set a bit in an integral type.
  *
@@ -276,7 +357,10 @@ template <class Storage>
 struct WordUpdate
 {
     WordUpdate() = default;
-    WordUpdate(Storage clear, Storage set) : toClear(clear), toSet(set) {}
+    constexpr WordUpdate(Storage clear, Storage set)
+        : toClear(clear), toSet(set)
+    {
+    }
 
     /// Bits set to '1' are forced to 0 in the final write.
     Storage toClear = static_cast<Storage>(0);
@@ -286,12 +370,21 @@ struct WordUpdate
 
     /// Merge 2 BitModification structures into 1. Bit set have priority
     /// over bit cleared.
-    static void apply(WordUpdate& lhs, const WordUpdate& rhs)
+    static constexpr void apply(WordUpdate& lhs, const WordUpdate& rhs)
     {
         lhs.toClear |= rhs.toClear;
         lhs.toSet |= rhs.toSet;
     }
 
+    /// Merge rhs into lhs so the result equals applying lhs, then rhs.
+    /// Unlike apply, a later write to a field replaces an earlier one.
+    static constexpr void sequence(WordUpdate& lhs, const WordUpdate& rhs)
+    {
+        lhs.toSet = static_cast<Storage>((lhs.toSet & ~rhs.toClear) |
+                                         rhs.toSet);
+        lhs.toClear |= rhs.toClear;
+    }
+
     // Create a new storage with a different width, preserving those
     // bits that remains. When casting to a smaller size, this is a
     // potentially destructive operation.
@@ -412,7 +505,7 @@ update(Storage& val, Storage clearValue, Storage setValue)
  * Bit sets have priority over bit clear.
  */
 template <class Storage>
-WordUpdate<Storage>
+constexpr WordUpdate<Storage>
 operator%(const WordUpdate<Storage>& lhs, const WordUpdate<Storage>& rhs)
 {
     WordUpdate<Storage> bm = lhs;
@@ -548,12 +641,12 @@ class BitField
 
     /// Return given value in 'bit modification form', suitable to be
     /// aggregated.
-    static WordUpdate<Storage> value(FieldType t);
+    static constexpr WordUpdate<Storage> value(FieldType t);
 
     /// Return given value in 'bit modification form', suitable to be
     /// aggregated.
     template <FieldType_ f>
-    static WordUpdate<Storage> value()
+    static constexpr WordUpdate<Storage> value()
     {
         const constexpr Storage sf = static_cast<Storage>(f);
         const constexpr Storage toSet = Rng::value2Storage(sf);
@@ -562,10 +655,10 @@ class BitField
     }
 
     /// Return modification to set all bits in field.
-    static WordUpdate<Storage> set();
+    static constexpr WordUpdate<Storage> set();
 
     /// Return modification to clear all bits in field.
-    static WordUpdate<Storage> clear();
+    static constexpr WordUpdate<Storage> clear();
 };
 
 /**
@@ -626,7 +719,7 @@ decodeBitField(typename BitField::Storage bits)
  * @return Field value read from storage.
  */
 template <typename BitField>
-typename BitField::Storage
+constexpr typename BitField::Storage
 encodeBitField(typename BitField::FieldType value)
 {
     int val = static_cast<int>(value);
@@ -656,7 +749,7 @@ encodeBitField()
 }
 
 template <typename Storage_, typename FieldType_, int offset_, int width_>
-WordUpdate<Storage_>
+constexpr WordUpdate<Storage_>
 BitField<Storage_, FieldType_, offset_, width_>::value(FieldType_ t)
 {
     const Storage toClear = bitFieldMask<BitField>();
@@ -665,14 +758,14 @@ BitField<Storage_, FieldType_, offset_, width_>::value(FieldType_ t)
 }
 
 template <typename Storage_, typename FieldType_, int offset_, int width_>
-WordUpdate<Storage_>
+constexpr WordUpdate<Storage_>
 BitField<Storage_, FieldType_, offset_, width_>::set()
 {
     return WordUpdate<Storage_>(0u, bitFieldMask<BitField>());
 }
 
 template <typename Storage_, typename FieldType_, int offset_, int width_>
-WordUpdate<Storage_>
+constexpr WordUpdate<Storage_>
 BitField<Storage_, FieldType_, offset_, width_>::clear()
 {
     return WordUpdate<Storage_>(bitFieldMask<BitField>(), 0u);
@@ -802,21 +895,21 @@ read(typename BitField::Storage bits)
 }
 
 template <typename BitField>
-WordUpdate<typename BitField::Register::RegStorage>
+constexpr WordUpdate<typename BitField::Register::RegStorage>
 value(typename BitField::Field::FieldType t)
 {
     return BitField::Field::value(t);
 }
 
 template <typename BitField>
-WordUpdate<typename BitField::Register::RegStorage>
+constexpr WordUpdate<typename BitField::Register::RegStorage>
 set()
 {
     return BitField::Field::set();
 }
 
 template <typename BitField>
-WordUpdate<typename BitField::Register::RegStorage>
+constexpr WordUpdate<typename BitField::Register::RegStorage>
 clear()
 {
     return BitField::Field::clear();
@@ -0,0 +1,385 @@
+#pragma once
+
+#include "bitops.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+/**
+ * Bitset operations over an array of Storage words owned by the user.
+ *
+ * Intended for allocation bitmaps (DMA channels, buffer pools, connection
+ * slots) where bit by bit scanning is too slow. All operations work a word
+ * at a time using popCount/countTrailingZeros. Bit 'i' is bit 'i % W' in
+ * word 'i / W' where W is the bit width of Storage.
+ *
+ * When compiled with AVX2, counting large ranges uses a vectorized
+ * popcount. With BMI2, selecting a bit within a 64 bit word uses pdep.
+ *
+ * For repeated rank/select on large static sets, build a rank_directory.
+ *
+ * Bits beyond 'size()' in the last word are never modified or counted.
+ */
+
+namespace bitops
+{
+
+namespace details
+{
+
+/// Count '1' bits in 'len' bytes starting at 'p'.
+inline std::size_t
+popCountBytes(const uint8_t* p, std::size_t len)
+{
+    std::size_t res = 0;
+#if defined(__AVX2__)
+    // Nibble lookup popcount, summed with sad_epu8 into 64 bit lanes.
+    if (len >= 64)
+    {
+        const __m256i lookup =
+            _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                             0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m256i low = _mm256_set1_epi8(0x0f);
+        __m256i acc = _mm256_setzero_si256();
+        while (len >= 32)
+        {
+            __m256i v =
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            __m256i lo = _mm256_and_si256(v, low);
+            __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low);
+            __m256i cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+                                          _mm256_shuffle_epi8(lookup, hi));
+            acc = _mm256_add_epi64(
+                acc, _mm256_sad_epu8(cnt, _mm256_setzero_si256()));
+            p += 32;
+            len -= 32;
+        }
+        res += static_cast<std::size_t>(_mm256_extract_epi64(acc, 0)) +
+               static_cast<std::size_t>(_mm256_extract_epi64(acc, 1)) +
+               static_cast<std::size_t>(_mm256_extract_epi64(acc, 2)) +
+               static_cast<std::size_t>(_mm256_extract_epi64(acc, 3));
+    }
+#endif
+    while (len >= sizeof(uint64_t))
+    {
+        uint64_t w;
+        std::memcpy(&w, p, sizeof(w));
+        res += popCount(w);
+        p += sizeof(w);
+        len -= sizeof(w);
+    }
+    while (len--)
+        res += popCount(*p++);
+    return res;
+}
+
+/// Return bit number of the k:th (0 based) set bit in value.
+/// Precondition: k < popCount(value).
+template <typename Storage>
+inline int
+selectInWord(Storage value, int k)
+{
+#if defined(__BMI2__) && defined(__x86_64__)
+    return countTrailingZeros(
+        _pdep_u64(1ull << k, static_cast<unsigned long long>(value)));
+#else
+    while (k--)
+        value = static_cast<Storage>(value & (value - 1u));
+    return countTrailingZeros(value);
+#endif
+}
+
+} // namespace details
+
+template <typename Storage>
+class bitset_view
+{
+  public:
+    enum
+    {
+        wordBits = bitWidth<Storage>(),
+    };
+
+    /// Returned by search functions when no bit is found.
+    static constexpr std::size_t npos = ~std::size_t(0);
+
+    bitset_view(Storage* words, std::size_t bitCount)
+        : m_words(words), m_size(bitCount)
+    {
+    }
+
+    std::size_t size() const
+    {
+        return m_size;
+    }
+
+    std::size_t wordCount() const
+    {
+        return (m_size + wordBits - 1) / wordBits;
+    }
+
+    Storage* data() const
+    {
+        return m_words;
+    }
+
+    bool test(std::size_t i) const
+    {
+        return (m_words[i / wordBits] >> (i % wordBits)) & 1u;
+    }
+
+    void set(std::size_t i) const
+    {
+        setBits(m_words[i / wordBits], bitMask(i));
+    }
+
+    void reset(std::size_t i) const
+    {
+        clearBits(m_words[i / wordBits], bitMask(i));
+    }
+
+    /// Number of set bits.
+    std::size_t count() const
+    {
+        return rank(m_size);
+    }
+
+    /// Number of set bits in [0, i).
+    std::size_t rank(std::size_t i) const
+    {
+        std::size_t full = i / wordBits;
+        std::size_t res = countWords(0, full);
+        int rest = i % wordBits;
+        if (rest)
+            res += popCount(
+                static_cast<Storage>(m_words[full] & lowMask(rest)));
+        return res;
+    }
+
+    /// Position of the k:th (0 based) set bit, or npos.
+    std::size_t select(std::size_t k) const
+    {
+        return selectFrom(0, k);
+    }
+
+    /// Position of the first set bit >= from, or npos.
+    std::size_t findNextSet(std::size_t from) const
+    {
+        return findNext(from, 0);
+    }
+
+    /// Position of the first clear bit >= from, or npos.
+    std::size_t findNextClear(std::size_t from) const
+    {
+        return findNext(from, static_cast<Storage>(~Storage(0)));
+    }
+
+    /// Set all bits in [first, last).
+    void setRange(std::size_t first, std::size_t last) const
+    {
+        modifyRange(first, last, true);
+    }
+
+    /// Clear all bits in [first, last).
+    void clearRange(std::size_t first, std::size_t last) const
+    {
+        modifyRange(first, last, false);
+    }
+
+    /// Position of the k:th set bit counting from word 'word', or npos.
+    std::size_t selectFrom(std::size_t word, std::size_t k) const
+    {
+        const std::size_t words = wordCount();
+        for (; word < words; ++word)
+        {
+            Storage w = maskedWord(word);
+            std::size_t cnt = popCount(w);
+            if (k < cnt)
+                return word * wordBits +
+                       details::selectInWord(w, static_cast<int>(k));
+            k -= cnt;
+        }
+        return npos;
+    }
+
+    /// Number of set bits in words [first, last).
+    std::size_t countWords(std::size_t first, std::size_t last) const
+    {
+        return details::popCountBytes(
+            reinterpret_cast<const uint8_t*>(m_words + first),
+            (last - first) * sizeof(Storage));
+    }
+
+  private:
+    static Storage bitMask(std::size_t i)
+    {
+        return static_cast<Storage>(Storage(1) << (i % wordBits));
+    }
+
+    static Storage lowMask(int bits)
+    {
+        return bits >= wordBits
+                   ? static_cast<Storage>(~Storage(0))
+                   : static_cast<Storage>((Storage(1) << bits) - 1u);
+    }
+
+    // Return word with bits beyond m_size cleared.
+    Storage maskedWord(std::size_t word) const
+    {
+        Storage w = m_words[word];
+        if (word == m_size / wordBits)
+            w = static_cast<Storage>(w & lowMask(m_size % wordBits));
+        return w;
+    }
+
+    // Search for a bit that differs from 'invert'.
+    std::size_t findNext(std::size_t from, Storage invert) const
+    {
+        if (from >= m_size)
+            return npos;
+        std::size_t word = from / wordBits;
+        Storage w = static_cast<Storage>(
+            (m_words[word] ^ invert) & ~lowMask(from % wordBits));
+        const std::size_t words = wordCount();
+        while (true)
+        {
+            if (w)
+            {
+                std::size_t pos = word * wordBits + countTrailingZeros(w);
+                return pos < m_size ? pos : npos;
+            }
+            if (++word >= words)
+                return npos;
+            w = static_cast<Storage>(m_words[word] ^ invert);
+        }
+    }
+
+    void modifyRange(std::size_t first, std::size_t last, bool value) const
+    {
+        if (first >= last)
+            return;
+        std::size_t fw = first / wordBits;
+        std::size_t lw = (last - 1) / wordBits;
+        Storage fm = static_cast<Storage>(~lowMask(first % wordBits));
+        Storage lm = lowMask((last - 1) % wordBits + 1);
+        if (fw == lw)
+        {
+            apply(m_words[fw], static_cast<Storage>(fm & lm), value);
+            return;
+        }
+        apply(m_words[fw], fm, value);
+        for (std::size_t i = fw + 1; i < lw; ++i)
+            m_words[i] = value ? static_cast<Storage>(~Storage(0)) : 0;
+        apply(m_words[lw], lm, value);
+    }
+
+    static void apply(Storage& w, Storage mask, bool value)
+    {
+        if (value)
+            setBits(w, mask);
+        else
+            clearBits(w, mask);
+    }
+
+    Storage* m_words;
+    std::size_t m_size;
+};
+
+template <typename Storage>
+constexpr std::size_t bitset_view<Storage>::npos;
+
+/**
+ * Precomputed cumulative counts for a bitset_view, giving O(1) rank and
+ * O(log n) select. Counts are stored per block of 512 bits, within a block
+ * at most 512 / W words are counted.
+ *
+ * The directory is a snapshot. Call rebuild() after modifying the bitset.
+ */
+template <typename Storage>
+class rank_directory
+{
+  public:
+    using View = bitset_view<Storage>;
+
+    enum
+    {
+        blockWords = 512 / View::wordBits,
+    };
+
+    explicit rank_directory(const View& view) : m_view(view)
+    {
+        rebuild();
+    }
+
+    void rebuild()
+    {
+        const std::size_t words = m_view.wordCount();
+        m_blocks.clear();
+        m_blocks.reserve(words / blockWords + 2);
+        m_blocks.push_back(0);
+        std::size_t sum = 0;
+        for (std::size_t w = 0; w < words; w += blockWords)
+        {
+            std::size_t end = w + blockWords < words ? w + blockWords : words;
+            sum += m_view.countWords(w, end);
+            m_blocks.push_back(sum);
+        }
+        // Do not count bits beyond size in the last word.
+        int rest = m_view.size() % View::wordBits;
+        if (rest)
+            m_blocks.back() -= popCount(static_cast<Storage>(
+                m_view.data()[words - 1] >> rest));
+    }
+
+    /// Number of set bits in [0, i).
+    std::size_t rank(std::size_t i) const
+    {
+        std::size_t word = i / View::wordBits;
+        std::size_t block = word / blockWords;
+        std::size_t res = m_blocks[block];
+        res += m_view.countWords(block * blockWords, word);
+        int rest = i % View::wordBits;
+        if (rest)
+            res += popCount(static_cast<Storage>(
+                m_view.data()[word] &
+                static_cast<Storage>((Storage(1) << rest) - 1u)));
+        return res;
+    }
+
+    /// Position of the k:th (0 based) set bit, or npos.
+    std::size_t select(std::size_t k) const
+    {
+        if (k >= m_blocks.back())
+            return View::npos;
+        // Find last block starting with count <= k.
+        std::size_t lo = 0;
+        std::size_t hi = m_blocks.size() - 1;
+        while (hi - lo > 1)
+        {
+            std::size_t mid = (lo + hi) / 2;
+            if (m_blocks[mid] <= k)
+                lo = mid;
+            else
+                hi = mid;
+        }
+        return m_view.selectFrom(lo * blockWords, k - m_blocks[lo]);
+    }
+
+    std::size_t count() const
+    {
+        return m_blocks.back();
+    }
+
+  private:
+    View m_view;
+    // m_blocks[b] = number of set bits before block b.
+    std::vector<std::size_t> m_blocks;
+};
+
+} // namespace bitops
@@ -0,0 +1,155 @@
+/*
+ * bitset_view_test.cpp
+ *
+ *  Tests for bitset_view and rank_directory, compared against a bit by bit
+ *  reference implementation.
+ */
+
+#include "bitset_view.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+namespace
+{
+
+// Fill words with random bits with a given density in percent.
+template <typename Storage>
+std::vector<Storage>
+randomWords(std::size_t bits, int density, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::size_t words = (bits + bitops::bitWidth<Storage>() - 1) /
+                        bitops::bitWidth<Storage>();
+    std::vector<Storage> res(words, 0);
+    bitops::bitset_view<Storage> v(res.data(), bits);
+    for (std::size_t i = 0; i < bits; ++i)
+        if (int(rng() % 100) < density)
+            v.set(i);
+    // Garbage beyond size, must be ignored.
+    int rest = bits % bitops::bitWidth<Storage>();
+    if (rest)
+        res.back() |= static_cast<Storage>(
+            static_cast<Storage>(~Storage(0)) << rest);
+    return res;
+}
+
+template <typename Storage>
+void
+checkAgainstReference(std::size_t bits, int density, unsigned seed)
+{
+    auto words = randomWords<Storage>(bits, density, seed);
+    bitops::bitset_view<Storage> v(words.data(), bits);
+    bitops::rank_directory<Storage> dir(v);
+    using View = bitops::bitset_view<Storage>;
+
+    std::vector<std::size_t> ones;
+    for (std::size_t i = 0; i < bits; ++i)
+        if (v.test(i))
+            ones.push_back(i);
+
+    ASSERT_EQ(v.count(), ones.size());
+    ASSERT_EQ(dir.count(), ones.size());
+
+    std::size_t r = 0;
+    for (std::size_t i = 0; i <= bits; ++i)
+    {
+        ASSERT_EQ(v.rank(i), r) << i;
+        ASSERT_EQ(dir.rank(i), r) << i;
+        if (i < bits && v.test(i))
+            r++;
+    }
+    for (std::size_t k = 0; k < ones.size(); ++k)
+    {
+        ASSERT_EQ(v.select(k), ones[k]);
+        ASSERT_EQ(dir.select(k), ones[k]);
+    }
+    EXPECT_EQ(v.select(ones.size()), View::npos);
+    EXPECT_EQ(dir.select(ones.size()), View::npos);
+
+    for (std::size_t i = 0; i < bits; ++i)
+    {
+        std::size_t ns = i;
+        while (ns < bits && !v.test(ns))
+            ns++;
+        ASSERT_EQ(v.findNextSet(i), ns < bits ? ns : View::npos);
+        std::size_t nc = i;
+        while (nc < bits && v.test(nc))
+            nc++;
+        ASSERT_EQ(v.findNextClear(i), nc < bits ? nc : View::npos);
+    }
+}
+
+} // namespace
+
+TEST(bitset_view, reference_uint8)
+{
+    for (std::size_t bits : {1, 7, 8, 9, 100, 1000})
+        checkAgainstReference<uint8_t>(bits, 30, bits);
+}
+
+TEST(bitset_view, reference_uint32)
+{
+    for (std::size_t bits : {31, 32, 33, 700, 5000})
+        checkAgainstReference<uint32_t>(bits, 50, bits);
+}
+
+TEST(bitset_view, reference_uint64)
+{
+    for (std::size_t bits : {64, 65, 513, 4096, 10000})
+    {
+        checkAgainstReference<uint64_t>(bits, 3, bits);
+        checkAgainstReference<uint64_t>(bits, 97, bits + 1);
+    }
+}
+
+TEST(bitset_view, ranges)
+{
+    std::vector<uint32_t> words(4, 0);
+    bitops::bitset_view<uint32_t> v(words.data(), 100);
+
+    v.setRange(3, 5);
+    EXPECT_EQ(words[0], 0x18u);
+    v.setRange(30, 70);
+    EXPECT_EQ(words[0], 0xc0000018u);
+    EXPECT_EQ(words[1], 0xffffffffu);
+    EXPECT_EQ(words[2], 0x3fu);
+    EXPECT_EQ(v.count(), 42u);
+
+    v.clearRange(31, 69);
+    EXPECT_EQ(words[0], 0x40000018u);
+    EXPECT_EQ(words[1], 0u);
+    EXPECT_EQ(words[2], 0x20u);
+
+    // Set to the end, bits beyond size are untouched.
+    v.setRange(90, 100);
+    EXPECT_EQ(words[3], 0xfu);
+    EXPECT_EQ(words[2], 0xfc000020u);
+    v.setRange(10, 10);
+    EXPECT_EQ(v.count(), 14u);
+}
+
+TEST(bitset_view, allocate_slots)
+{
+    // Typical allocator use: find a free slot, mark it used.
+    std::vector<uint64_t> words(2, 0);
+    bitops::bitset_view<uint64_t> used(words.data(), 70);
+    for (std::size_t i = 0; i < 70; ++i)
+    {
+        std::size_t slot = used.findNextClear(0);
+        ASSERT_EQ(slot, i);
+        used.set(slot);
+    }
+    EXPECT_EQ(used.findNextClear(0), used.npos);
+    used.reset(65);
+    EXPECT_EQ(used.findNextClear(0), 65u);
+}
+
+int
+main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
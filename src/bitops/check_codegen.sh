@@ -0,0 +1,100 @@
+#!/bin/sh
+
+# Compile codegen_samples.cpp for the host (x86_64) and, when
+# arm-none-eabi-g++ is available, for ARMv6-M and ARMv7-M. Disassemble and
+# compare instruction and load counts per function with
+# codegen_expected.txt. Exit status is non zero on any regression.
+
+# Absolute path this script is in.
+SCRIPT=$(readlink -f $0)
+SCRIPTPATH=`dirname $SCRIPT`
+
+SRC=${SCRIPTPATH}/codegen_samples.cpp
+EXPECTED=${SCRIPTPATH}/codegen_expected.txt
+OUT=${TMPDIR:-/tmp}/bitops_codegen.$$
+mkdir -p ${OUT}
+trap 'rm -rf ${OUT}' EXIT
+
+CXXFLAGS="-std=c++14 -O2 -ffunction-sections -I${SCRIPTPATH}"
+CXXFLAGS="${CXXFLAGS} -fno-asynchronous-unwind-tables"
+FAIL=0
+
+# Disassemble an object file, intel syntax where supported.
+disassemble() {
+    objdump=$1
+    obj=$2
+    ${objdump} -d --no-show-raw-insn -M intel ${obj} 2>/dev/null ||
+        ${objdump} -d --no-show-raw-insn ${obj}
+}
+
+# Print "function instructions loads" for each function in a disassembly.
+summarize() {
+    awk '
+    /^[0-9a-f]+ <.*>:$/ {
+        if (fn != "") print fn, insns, loads
+        fn = $2; gsub(/[<>:]/, "", fn); insns = 0; loads = 0; next
+    }
+    /^ *[0-9a-f]+:\t/ && fn != "" {
+        split($0, parts, "\t"); ins = parts[2]
+        if (ins == "" || ins ~ /^(nop|\.word|\.short)/) next
+        insns++
+        op = ins; sub(/ .*/, "", op)
+        if (ins ~ /PTR \[/) {
+            # x86, intel syntax: memory read unless plain mov store.
+            if (op != "mov" || ins ~ /,.*PTR \[/) loads++
+        } else if (op ~ /^ldr/ && ins !~ /\[pc/) {
+            loads++
+        }
+    }
+    END { if (fn != "") print fn, insns, loads }'
+}
+
+check() {
+    target=$1
+    cxx=$2
+    objdump=$3
+    shift 3
+    obj=${OUT}/${target}.o
+    if ! ${cxx} ${CXXFLAGS} "$@" -c ${SRC} -o ${obj}; then
+        echo "FAIL ${target}: compilation failed"
+        FAIL=1
+        return
+    fi
+    disassemble ${objdump} ${obj} | summarize > ${OUT}/${target}.txt
+    grep "^${target} " ${EXPECTED} | while read t fn maxInsns maxLoads; do
+        res=`grep "^${fn} " ${OUT}/${target}.txt`
+        if [ -z "${res}" ]; then
+            echo "FAIL ${target} ${fn}: not found"
+            echo 1 > ${OUT}/fail
+            continue
+        fi
+        set -- ${res}
+        if [ $2 -gt ${maxInsns} ] || [ $3 -gt ${maxLoads} ]; then
+            echo "FAIL ${target} ${fn}: $2 instructions, $3 loads" \
+                 "(max ${maxInsns}, ${maxLoads})"
+            ${objdump} -d --no-show-raw-insn ${obj} |
+                sed -n "/<${fn}>:/,/^$/p"
+            echo 1 > ${OUT}/fail
+        else
+            echo "ok   ${target} ${fn}: $2 instructions, $3 loads"
+        fi
+    done
+}
+
+if [ `uname -m` = x86_64 ]; then
+    check x86_64 ${CXX:-g++} objdump
+else
+    echo "skip x86_64: host is not x86_64"
+fi
+
+if command -v arm-none-eabi-g++ > /dev/null; then
+    check armv6m arm-none-eabi-g++ arm-none-eabi-objdump -mcpu=cortex-m0 -mthumb
+    check armv7m arm-none-eabi-g++ arm-none-eabi-objdump -mcpu=cortex-m3 -mthumb
+else
+    echo "skip armv6m, armv7m: arm-none-eabi-g++ not found"
+fi
+
+if [ -f ${OUT}/fail ] || [ ${FAIL} -ne 0 ]; then
+    exit 1
+fi
+exit 0
@@ -0,0 +1,82 @@
+/*
+ * codegen_samples.cpp
+ *
+ *  Representative bitops operations compiled by check_codegen.sh. The
+ *  generated code for each function is disassembled and checked against
+ *  codegen_expected.txt, catching template changes that stop the hot paths
+ *  from compiling into single set/clear instructions.
+ *
+ *  Functions are extern "C" to get stable symbol names on all targets.
+ */
+
+#include "bitops.h"
+
+using Bit4 = bitops::BitField<uint32_t, int, 4, 1>;
+using Nib8 = bitops::BitField<uint32_t, int, 8, 4>;
+using Bit3h = bitops::BitField<uint16_t, int, 3, 1>;
+
+extern "C" {
+
+// WriteImplSpecialize1Bit, set. Expect a single 'or' to memory.
+void
+cg_write_1bit_set(uint32_t* r)
+{
+    bitops::write<Bit4, 1>(*r);
+}
+
+// WriteImplSpecialize1Bit, clear. Expect a single 'and' to memory.
+void
+cg_write_1bit_clear(uint32_t* r)
+{
+    bitops::write<Bit4, 0>(*r);
+}
+
+// WriteImplSpecializeSetClear, both clear and set bits needed.
+void
+cg_write_field_const(uint32_t* r)
+{
+    bitops::write<Nib8, 5>(*r);
+}
+
+// WriteImplSpecializeSetClear, only set bits.
+void
+cg_write_field_ones(uint32_t* r)
+{
+    bitops::write<Nib8, 15>(*r);
+}
+
+// WriteImplSpecializeSetClear, only clear bits.
+void
+cg_write_field_zero(uint32_t* r)
+{
+    bitops::write<Nib8, 0>(*r);
+}
+
+// Runtime field value.
+void
+cg_write_field_runtime(uint32_t* r, int v)
+{
+    bitops::write<Nib8>(*r, v);
+}
+
+// Merged WordUpdate applied to a volatile register. One load, one store.
+void
+cg_update_merged(volatile uint32_t* r)
+{
+    bitops::update(*r, Bit4::value<1>() % Nib8::value<5>());
+}
+
+// 16 bit storage.
+void
+cg_write_16bit(uint16_t* r)
+{
+    bitops::write<Bit3h, 1>(*r);
+}
+
+// Compile time setBits on a volatile register.
+void
+cg_set_bits_volatile(volatile uint32_t* r)
+{
+    bitops::setBits<uint32_t, 0x30>(*r);
+}
+}
@@ -0,0 +1,372 @@
+#pragma once
+
+#include "bitops.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * CRC engine with lookup tables generated at compile time.
+ *
+ * A crc type is described by the usual parameters of the Rocksoft model.
+ * Input and output reflection are always equal, which covers the common
+ * CRC-8/16/32 variants. Three implementations share the same register
+ * representation and can be mixed freely:
+ *
+ * - bitwise: No table. Smallest code, slowest.
+ * - table: One 256 entry table, one lookup per byte.
+ * - slice8: Seven more tables, 8 bytes per iteration, if width % 8 == 0.
+ *
+ * The 'impl' parameter selects what update() and compute() use, table by
+ * default. Only the tables of the functions actually called are linked,
+ * so e.g. crc32 costs 1 KiB of tables unless slice8 is used, then 8 KiB.
+ * crc32::with<crc_impl::slice8> is the same CRC using slice8 for buffers
+ * of 16 bytes or more. All functions are constexpr, so CRCs of constant
+ * data can be computed at compile time.
+ *
+ * static_assert(bitops::crc32::compute("123456789", 9) == 0xcbf43926, "");
+ *
+ * bitops::crc32 c;
+ * c.update(header, sizeof header);
+ * c.update(payload, len);
+ * uint32_t res = c.value();
+ *
+ * @param poly Generator polynomial, normal (not reflected) form.
+ * @param width Number of bits in the CRC, 8 to 64.
+ * @param reflect True for LSB first (reflected) algorithms.
+ * @param init Initial register value, normal form.
+ * @param xorOut Value XOR:ed to the final register.
+ * @param impl Implementation used by update() and compute().
+ */
+
+namespace bitops
+{
+
+enum class crc_impl
+{
+    bitwise,
+    table,
+    slice8
+};
+
+namespace details
+{
+
+// Smallest unsigned type holding 'width' bits.
+template <int width>
+using CrcValue = typename std::conditional<
+    (width <= 8), uint8_t,
+    typename std::conditional<
+        (width <= 16), uint16_t,
+        typename std::conditional<(width <= 32), uint32_t,
+                                  uint64_t>::type>::type>::type;
+
+template <typename Value, int slices>
+struct CrcTables
+{
+    Value t[slices][256];
+};
+
+// Separate holders so tables can be built by constexpr functions of the
+// complete Crc class, and so the slice tables are only instantiated, and
+// linked, when slice8 is used.
+template <class Crc>
+struct CrcTableHolder
+{
+    static constexpr typename Crc::ByteTable table = Crc::makeByteTable();
+};
+
+template <class Crc>
+constexpr typename Crc::ByteTable CrcTableHolder<Crc>::table;
+
+template <class Crc>
+struct CrcSliceHolder
+{
+    static constexpr typename Crc::SliceTables tables =
+        Crc::makeSliceTables();
+};
+
+template <class Crc>
+constexpr typename Crc::SliceTables CrcSliceHolder<Crc>::tables;
+
+} // namespace details
+
+template <uint64_t poly, int width, bool reflect, uint64_t init = 0,
+          uint64_t xorOut = 0, crc_impl impl = crc_impl::table>
+class crc
+{
+  public:
+    using Value = details::CrcValue<width>;
+
+    /// The same CRC with another implementation for update().
+    template <crc_impl other>
+    using with = crc<poly, width, reflect, init, xorOut, other>;
+
+    static_assert(width >= 8 && width <= 64, "Unsupported CRC width.");
+
+    enum
+    {
+        canSlice = width % 8 == 0,
+    };
+
+    constexpr crc() = default;
+
+    /// Add data to the CRC.
+    template <typename Byte>
+    constexpr crc& update(const Byte* data, std::size_t len)
+    {
+        m_reg = update(m_reg, data, len);
+        return *this;
+    }
+
+    /// CRC of the data added so far.
+    constexpr Value value() const
+    {
+        return finish(m_reg);
+    }
+
+    constexpr void reset()
+    {
+        m_reg = start();
+    }
+
+    /// CRC of a complete buffer.
+    template <typename Byte>
+    static constexpr Value compute(const Byte* data, std::size_t len)
+    {
+        return finish(update(start(), data, len));
+    }
+
+    /// Initial register value.
+    static constexpr Value start()
+    {
+        return reflect ? reverseBits(static_cast<Value>(init << shift))
+                       : static_cast<Value>(init);
+    }
+
+    /// Final CRC from a register value.
+    static constexpr Value finish(Value reg)
+    {
+        return static_cast<Value>((reg ^ xorOut) & mask);
+    }
+
+    /// Add data to a register value, using the 'impl' implementation.
+    template <typename Byte>
+    static constexpr Value update(Value reg, const Byte* data,
+                                  std::size_t len)
+    {
+        return update(Impl<impl>(), reg, data, len);
+    }
+
+    /// Add data to a register value, one bit at a time.
+    template <typename Byte>
+    static constexpr Value bitwise(Value reg, const Byte* data,
+                                   std::size_t len)
+    {
+        for (std::size_t i = 0; i < len; ++i)
+            reg = bitwiseByte(reg, static_cast<uint8_t>(data[i]));
+        return reg;
+    }
+
+    /// Add data to a register value, one table lookup per byte.
+    template <typename Byte>
+    static constexpr Value table(Value reg, const Byte* data,
+                                 std::size_t len)
+    {
+        for (std::size_t i = 0; i < len; ++i)
+            reg = tableByte(reg, static_cast<uint8_t>(data[i]));
+        return reg;
+    }
+
+    /// Add data to a register value, 8 bytes per iteration.
+    /// Same as table() if width is not a multiple of 8.
+    template <typename Byte>
+    static constexpr Value slice8(Value reg, const Byte* data,
+                                  std::size_t len)
+    {
+        return slice8(std::integral_constant<bool, bool(canSlice)>(), reg, data,
+                      len);
+    }
+
+  private:
+    template <crc_impl i>
+    using Impl = std::integral_constant<crc_impl, i>;
+
+    template <typename Byte>
+    static constexpr Value slice8(std::false_type, Value reg,
+                                  const Byte* data, std::size_t len)
+    {
+        return table(reg, data, len);
+    }
+
+    template <typename Byte>
+    static constexpr Value slice8(std::true_type, Value reg,
+                                  const Byte* data, std::size_t len)
+    {
+        const auto& t = details::CrcSliceHolder<crc>::tables.t;
+        const auto& t0 = details::CrcTableHolder<crc>::table.t[0];
+        for (; len >= 8; len -= 8, data += 8)
+        {
+            // Data in processing order, register XOR:ed into the first
+            // bytes. Byte i is at bit 8 * i (reflected) or 56 - 8 * i.
+            // t[k - 1] is the table for k zero bytes following.
+            uint64_t x = load64(data) ^ alignedReg(reg);
+            reg = t[6][byteAt(x, 0)] ^ t[5][byteAt(x, 1)] ^
+                  t[4][byteAt(x, 2)] ^ t[3][byteAt(x, 3)] ^
+                  t[2][byteAt(x, 4)] ^ t[1][byteAt(x, 5)] ^
+                  t[0][byteAt(x, 6)] ^ t0[byteAt(x, 7)];
+        }
+        return table(reg, data, len);
+    }
+
+    // Tag dispatch, so only the tables of the selected implementation are
+    // instantiated.
+    template <typename Byte>
+    static constexpr Value update(Impl<crc_impl::bitwise>, Value reg,
+                                  const Byte* data, std::size_t len)
+    {
+        return bitwise(reg, data, len);
+    }
+
+    template <typename Byte>
+    static constexpr Value update(Impl<crc_impl::table>, Value reg,
+                                  const Byte* data, std::size_t len)
+    {
+        return table(reg, data, len);
+    }
+
+    template <typename Byte>
+    static constexpr Value update(Impl<crc_impl::slice8>, Value reg,
+                                  const Byte* data, std::size_t len)
+    {
+        return len >= 16 ? slice8(reg, data, len) : table(reg, data, len);
+    }
+
+    enum
+    {
+        // Shift to align a 'width' bit value to the top of Value.
+        shift = 8 * sizeof(Value) - width,
+    };
+
+    static constexpr Value mask =
+        static_cast<Value>(~0ull >> (64 - width));
+
+    static constexpr Value bitwiseByte(Value reg, uint8_t b)
+    {
+        if (reflect)
+        {
+            const Value rpoly =
+                reverseBits(static_cast<Value>(poly << shift));
+            reg = static_cast<Value>(reg ^ b);
+            for (int i = 0; i < 8; ++i)
+                reg = static_cast<Value>(reg & 1 ? (reg >> 1) ^ rpoly
+                                                 : reg >> 1);
+            return reg;
+        }
+        const Value top = static_cast<Value>(Value(1) << (width - 1));
+        reg = static_cast<Value>(reg ^ (Value(b) << (width - 8)));
+        for (int i = 0; i < 8; ++i)
+            reg = static_cast<Value>(reg & top ? (reg << 1) ^ poly
+                                               : reg << 1);
+        return static_cast<Value>(reg & mask);
+    }
+
+    static constexpr Value tableByte(Value reg, uint8_t b)
+    {
+        return tableStep(reg, b, details::CrcTableHolder<crc>::table.t[0]);
+    }
+
+    static constexpr Value tableStep(Value reg, uint8_t b,
+                                     const Value (&t0)[256])
+    {
+        if (reflect)
+            return static_cast<Value>((width > 8 ? reg >> 8 : 0) ^
+                                      t0[(reg ^ b) & 0xff]);
+        return static_cast<Value>(
+            ((width > 8 ? reg << 8 : 0) ^
+             t0[((reg >> (width - 8)) ^ b) & 0xff]) &
+            mask);
+    }
+
+    // Load 8 bytes, little endian if reflected, otherwise big endian.
+    // Written as byte operations to stay constexpr, compilers merge this
+    // into a single load.
+    template <typename Byte>
+    static constexpr uint64_t load64(const Byte* p)
+    {
+        return at(p, 0) | at(p, 1) | at(p, 2) | at(p, 3) | at(p, 4) |
+               at(p, 5) | at(p, 6) | at(p, 7);
+    }
+
+    // Byte 'i' of 'p' at its load64 position.
+    template <typename Byte>
+    static constexpr uint64_t at(const Byte* p, int i)
+    {
+        return uint64_t(static_cast<uint8_t>(p[i]))
+               << (reflect ? 8 * i : 56 - 8 * i);
+    }
+
+    // Byte 'i' in processing order of a value from load64.
+    static constexpr uint8_t byteAt(uint64_t x, int i)
+    {
+        return static_cast<uint8_t>(x >> (reflect ? 8 * i : 56 - 8 * i));
+    }
+
+    // Register placed at the bytes processed first.
+    static constexpr uint64_t alignedReg(Value reg)
+    {
+        return reflect ? uint64_t(reg) : uint64_t(reg) << (64 - width);
+    }
+
+    using ByteTable = details::CrcTables<Value, 1>;
+    using SliceTables = details::CrcTables<Value, 7>;
+
+    static constexpr ByteTable makeByteTable()
+    {
+        ByteTable res{};
+        for (int b = 0; b < 256; ++b)
+            res.t[0][b] = bitwiseByte(0, static_cast<uint8_t>(b));
+        return res;
+    }
+
+    // t[k - 1][b]: CRC of byte b followed by k zero bytes.
+    static constexpr SliceTables makeSliceTables()
+    {
+        SliceTables res{};
+        const auto& t0 = details::CrcTableHolder<crc>::table.t[0];
+        for (int b = 0; b < 256; ++b)
+            res.t[0][b] = tableStep(t0[b], 0, t0);
+        for (int k = 1; k < 7; ++k)
+            for (int b = 0; b < 256; ++b)
+                res.t[k][b] = tableStep(res.t[k - 1][b], 0, t0);
+        return res;
+    }
+
+    friend struct details::CrcTableHolder<crc>;
+    friend struct details::CrcSliceHolder<crc>;
+
+    Value m_reg = start();
+};
+
+template <uint64_t poly, int width, bool reflect, uint64_t init,
+          uint64_t xorOut, crc_impl impl>
+constexpr typename crc<poly, width, reflect, init, xorOut, impl>::Value
+    crc<poly, width, reflect, init, xorOut, impl>::mask;
+
+/// CRC-8, poly 0x07 (SMBus).
+using crc8 = crc<0x07, 8, false>;
+
+/// CRC-16/CCITT-FALSE.
+using crc16_ccitt_false = crc<0x1021, 16, false, 0xffff>;
+
+/// CRC-16/ARC (IBM).
+using crc16_arc = crc<0x8005, 16, true>;
+
+/// CRC-32 (Ethernet, zlib).
+using crc32 = crc<0x04c11db7, 32, true, 0xffffffff, 0xffffffff>;
+
+/// CRC-32C (Castagnoli).
+using crc32c = crc<0x1edc6f41, 32, true, 0xffffffff, 0xffffffff>;
+
+} // namespace bitops
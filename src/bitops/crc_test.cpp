@@ -0,0 +1,108 @@
+/*
+ * crc_test.cpp
+ *
+ *  Tests for the CRC engine. Check values are the standard CRC of the
+ *  ASCII string "123456789".
+ */
+
+#include "crc.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+
+constexpr char check[] = "123456789";
+
+template <class Crc>
+void
+expectAllEqual(typename Crc::Value expected)
+{
+    using V = typename Crc::Value;
+    const std::size_t n = 9;
+    EXPECT_EQ(Crc::compute(check, n), expected);
+    EXPECT_EQ(Crc::finish(Crc::bitwise(Crc::start(), check, n)), expected);
+    EXPECT_EQ(Crc::finish(Crc::table(Crc::start(), check, n)), expected);
+
+    // Streaming in pieces.
+    Crc c;
+    c.update(check, 4).update(check + 4, 5);
+    EXPECT_EQ(c.value(), expected);
+    c.reset();
+    c.update(check, n);
+    EXPECT_EQ(c.value(), V(expected));
+}
+
+// Compare all implementations on a longer pseudo random buffer.
+template <class Crc>
+void
+expectSameOnLongData()
+{
+    std::vector<uint8_t> data(1000);
+    uint32_t x = 12345;
+    for (auto& d : data)
+    {
+        x = x * 1103515245u + 12345u;
+        d = static_cast<uint8_t>(x >> 16);
+    }
+    for (std::size_t len : {0u, 1u, 7u, 8u, 15u, 16u, 17u, 999u, 1000u})
+    {
+        auto ref = Crc::bitwise(Crc::start(), data.data(), len);
+        EXPECT_EQ(Crc::table(Crc::start(), data.data(), len), ref);
+        EXPECT_EQ(Crc::slice8(Crc::start(), data.data(), len), ref);
+        EXPECT_EQ(Crc::update(Crc::start(), data.data(), len), ref);
+        using Bitwise = typename Crc::template with<bitops::crc_impl::bitwise>;
+        using Slice8 = typename Crc::template with<bitops::crc_impl::slice8>;
+        EXPECT_EQ(Bitwise::update(Crc::start(), data.data(), len), ref);
+        EXPECT_EQ(Slice8::update(Crc::start(), data.data(), len), ref);
+    }
+}
+
+} // namespace
+
+TEST(crc, check_values)
+{
+    expectAllEqual<bitops::crc8>(0xf4);
+    expectAllEqual<bitops::crc16_ccitt_false>(0x29b1);
+    expectAllEqual<bitops::crc16_arc>(0xbb3d);
+    expectAllEqual<bitops::crc32>(0xcbf43926u);
+    expectAllEqual<bitops::crc32c>(0xe3069283u);
+
+    // CRC-64/XZ.
+    using crc64 = bitops::crc<0x42f0e1eba9ea3693ull, 64, true, ~0ull, ~0ull>;
+    expectAllEqual<crc64>(0x995dc9bbdf1939faull);
+
+    // Width not a multiple of 8, CRC-12/DECT.
+    using crc12 = bitops::crc<0x80f, 12, false>;
+    expectAllEqual<crc12>(0xf5b);
+}
+
+TEST(crc, constexpr_compute)
+{
+    static_assert(bitops::crc32::compute(check, 9) == 0xcbf43926u, "");
+    static_assert(bitops::crc16_ccitt_false::compute(check, 9) == 0x29b1,
+                  "");
+    constexpr auto c = bitops::crc8().update(check, 9).value();
+    static_assert(c == 0xf4, "");
+    using crc32s = bitops::crc32::with<bitops::crc_impl::slice8>;
+    static_assert(crc32s::compute(check, 9) == 0xcbf43926u, "");
+}
+
+TEST(crc, slice8_matches_table)
+{
+    expectSameOnLongData<bitops::crc8>();
+    expectSameOnLongData<bitops::crc16_ccitt_false>();
+    expectSameOnLongData<bitops::crc16_arc>();
+    expectSameOnLongData<bitops::crc32>();
+    expectSameOnLongData<bitops::crc<0x42f0e1eba9ea3693ull, 64, false>>();
+}
+
+int
+main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,267 @@
+#pragma once
+
+#include "bitops.h"
+
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+
+/**
+ * Type safe set of flags, where each flag is an enumerator giving a bit
+ * number in the storage word.
+ *
+ * Replaces hand rolled flag words with mixed int/enum arithmetic. All
+ * operations are done in the Storage type, values are cast back after each
+ * operation to avoid carrying around promoted 'int' temporaries.
+ *
+ * enum class Ev { rxDone, txDone, error };
+ * using EvFlags = bitops::flags<Ev, uint8_t>;
+ *
+ * constexpr EvFlags wakeup{Ev::rxDone, Ev::error};
+ * for (Ev e : pending) { ... }       // Visit set flags, lowest first.
+ * reg %= wakeup.setUpdate();         // Convert into a WordUpdate.
+ * wakeup.setIn(atomicEventWord);     // Post as atomic event flags.
+ *
+ * @param Enum enumeration type where each value is a bit number.
+ * @param Storage unsigned integral type holding the bits.
+ */
+
+namespace bitops
+{
+
+template <typename Enum, typename Storage = uint32_t>
+class flags
+{
+  public:
+    using EnumType = Enum;
+    using StorageType = Storage;
+
+    /// Iterate over set flags in increasing bit order.
+    class iterator
+    {
+      public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Enum;
+        using difference_type = int;
+        using pointer = const Enum*;
+        using reference = Enum;
+
+        constexpr explicit iterator(Storage rest) : m_rest(rest) {}
+
+        constexpr Enum operator*() const
+        {
+            return static_cast<Enum>(countTrailingZeros(m_rest));
+        }
+
+        constexpr iterator& operator++()
+        {
+            // Clear lowest set bit.
+            m_rest = static_cast<Storage>(m_rest & (m_rest - 1u));
+            return *this;
+        }
+
+        constexpr iterator operator++(int)
+        {
+            iterator res = *this;
+            ++*this;
+            return res;
+        }
+
+        constexpr bool operator==(const iterator& rhs) const
+        {
+            return m_rest == rhs.m_rest;
+        }
+
+        constexpr bool operator!=(const iterator& rhs) const
+        {
+            return m_rest != rhs.m_rest;
+        }
+
+      private:
+        Storage m_rest;
+    };
+
+    constexpr flags() = default;
+
+    constexpr flags(Enum e) : m_bits(bit(e)) {}
+
+    constexpr flags(std::initializer_list<Enum> list)
+    {
+        for (auto e : list)
+            m_bits = static_cast<Storage>(m_bits | bit(e));
+    }
+
+    /// Construct from a raw storage value.
+    static constexpr flags fromStorage(Storage s)
+    {
+        flags f;
+        f.m_bits = s;
+        return f;
+    }
+
+    /// Return the storage bit mask for one flag.
+    static constexpr Storage bit(Enum e)
+    {
+        return static_cast<Storage>(Storage(1) << static_cast<unsigned>(e));
+    }
+
+    constexpr flags& set(Enum e)
+    {
+        m_bits = static_cast<Storage>(m_bits | bit(e));
+        return *this;
+    }
+
+    constexpr flags& clear(Enum e)
+    {
+        m_bits = static_cast<Storage>(m_bits & ~bit(e));
+        return *this;
+    }
+
+    constexpr flags& clear()
+    {
+        m_bits = 0;
+        return *this;
+    }
+
+    constexpr bool test(Enum e) const
+    {
+        return (m_bits & bit(e)) != 0;
+    }
+
+    /// Add all flags set in 'rhs' to this set.
+    constexpr flags& merge(flags rhs)
+    {
+        m_bits = static_cast<Storage>(m_bits | rhs.m_bits);
+        return *this;
+    }
+
+    /// Return true if any of the flags in 'rhs' are set.
+    constexpr bool any(flags rhs) const
+    {
+        return (m_bits & rhs.m_bits) != 0;
+    }
+
+    /// Return true if all of the flags in 'rhs' are set.
+    constexpr bool all(flags rhs) const
+    {
+        return (m_bits & rhs.m_bits) == rhs.m_bits;
+    }
+
+    constexpr bool none() const
+    {
+        return m_bits == 0;
+    }
+
+    constexpr explicit operator bool() const
+    {
+        return m_bits != 0;
+    }
+
+    /// Number of set flags.
+    constexpr int count() const
+    {
+        return popCount(m_bits);
+    }
+
+    constexpr Storage value() const
+    {
+        return m_bits;
+    }
+
+    constexpr iterator begin() const
+    {
+        return iterator(m_bits);
+    }
+
+    constexpr iterator end() const
+    {
+        return iterator(0);
+    }
+
+    /// WordUpdate that sets the flags in this set, leaving other bits.
+    constexpr WordUpdate<Storage> setUpdate() const
+    {
+        return WordUpdate<Storage>(0, m_bits);
+    }
+
+    /// WordUpdate that clears the flags in this set, leaving other bits.
+    constexpr WordUpdate<Storage> clearUpdate() const
+    {
+        return WordUpdate<Storage>(m_bits, 0);
+    }
+
+    /// WordUpdate that makes the flags within 'mask' equal to this set.
+    constexpr WordUpdate<Storage> assignUpdate(flags mask) const
+    {
+        return WordUpdate<Storage>(
+            static_cast<Storage>(mask.m_bits & ~m_bits),
+            static_cast<Storage>(mask.m_bits & m_bits));
+    }
+
+    /// Atomically set these flags in an event word.
+    void setIn(std::atomic<Storage>& word,
+               std::memory_order mo = std::memory_order_seq_cst) const
+    {
+        word.fetch_or(m_bits, mo);
+    }
+
+    /// Atomically clear these flags in an event word.
+    void clearIn(std::atomic<Storage>& word,
+                 std::memory_order mo = std::memory_order_seq_cst) const
+    {
+        word.fetch_and(static_cast<Storage>(~m_bits), mo);
+    }
+
+    /// Atomically take and clear all flags in an event word.
+    static flags take(std::atomic<Storage>& word,
+                      std::memory_order mo = std::memory_order_seq_cst)
+    {
+        return fromStorage(word.exchange(0, mo));
+    }
+
+    /// Atomically take and clear the flags in 'mask' from an event word.
+    static flags take(std::atomic<Storage>& word, flags mask,
+                      std::memory_order mo = std::memory_order_seq_cst)
+    {
+        Storage old = word.fetch_and(static_cast<Storage>(~mask.m_bits), mo);
+        return fromStorage(static_cast<Storage>(old & mask.m_bits));
+    }
+
+    /// Read the current flags of an event word.
+    static flags load(const std::atomic<Storage>& word,
+                      std::memory_order mo = std::memory_order_seq_cst)
+    {
+        return fromStorage(word.load(mo));
+    }
+
+    friend constexpr flags operator|(flags lhs, flags rhs)
+    {
+        return fromStorage(static_cast<Storage>(lhs.m_bits | rhs.m_bits));
+    }
+
+    friend constexpr flags operator&(flags lhs, flags rhs)
+    {
+        return fromStorage(static_cast<Storage>(lhs.m_bits & rhs.m_bits));
+    }
+
+    friend constexpr flags operator^(flags lhs, flags rhs)
+    {
+        return fromStorage(static_cast<Storage>(lhs.m_bits ^ rhs.m_bits));
+    }
+
+    friend constexpr bool operator==(flags lhs, flags rhs)
+    {
+        return lhs.m_bits == rhs.m_bits;
+    }
+
+    friend constexpr bool operator!=(flags lhs, flags rhs)
+    {
+        return lhs.m_bits != rhs.m_bits;
+    }
+
+  private:
+    Storage m_bits = 0;
+};
+
+} // namespace bitops
@@ -0,0 +1,134 @@
+/*
+ * flags_test.cpp
+ *
+ *  Tests for the typed flag set.
+ */
+
+#include "flags.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace
+{
+
+enum class Ev
+{
+    rxDone = 0,
+    txDone = 1,
+    error = 5,
+    timeout = 7,
+};
+
+using EvFlags = bitops::flags<Ev, uint8_t>;
+
+enum class Big
+{
+    low = 0,
+    high = 63,
+};
+
+} // namespace
+
+TEST(flags, set_clear_test)
+{
+    EvFlags f;
+    EXPECT_TRUE(f.none());
+    EXPECT_FALSE(f);
+
+    f.set(Ev::txDone).set(Ev::timeout);
+    EXPECT_TRUE(f.test(Ev::txDone));
+    EXPECT_TRUE(f.test(Ev::timeout));
+    EXPECT_FALSE(f.test(Ev::rxDone));
+    EXPECT_EQ(f.value(), 0x82);
+    EXPECT_EQ(f.count(), 2);
+
+    f.clear(Ev::timeout);
+    EXPECT_EQ(f.value(), 0x02);
+    f.clear();
+    EXPECT_TRUE(f.none());
+}
+
+TEST(flags, constexpr_ops)
+{
+    constexpr EvFlags a{Ev::rxDone, Ev::error};
+    constexpr EvFlags b = EvFlags(Ev::error) | Ev::timeout;
+    static_assert(a.value() == 0x21, "");
+    static_assert(b.value() == 0xa0, "");
+    static_assert((a & b) == EvFlags(Ev::error), "");
+    static_assert((a ^ b).value() == 0x81, "");
+    static_assert(a.any(b), "");
+    static_assert(!a.all(b), "");
+    static_assert(a.count() == 2, "");
+    static_assert(EvFlags(a).merge(b).value() == 0xa1, "");
+
+    constexpr auto wu = a.setUpdate();
+    static_assert(wu.toSet == 0x21 && wu.toClear == 0, "");
+    constexpr auto wu2 = a.assignUpdate(b | Ev::rxDone);
+    static_assert(wu2.toSet == 0x21 && wu2.toClear == 0x80, "");
+}
+
+TEST(flags, iterate)
+{
+    EvFlags f{Ev::timeout, Ev::rxDone, Ev::error};
+    std::vector<Ev> seen;
+    for (Ev e : f)
+        seen.push_back(e);
+    std::vector<Ev> expected{Ev::rxDone, Ev::error, Ev::timeout};
+    EXPECT_EQ(seen, expected);
+
+    EXPECT_TRUE(EvFlags().begin() == EvFlags().end());
+
+    bitops::flags<Big, uint64_t> big{Big::low, Big::high};
+    std::vector<Big> seenBig(big.begin(), big.end());
+    ASSERT_EQ(seenBig.size(), 2u);
+    EXPECT_EQ(seenBig[1], Big::high);
+    EXPECT_EQ(big.count(), 2);
+}
+
+TEST(flags, word_update)
+{
+    uint8_t reg = 0x0f;
+    reg %= EvFlags(Ev::timeout).setUpdate();
+    EXPECT_EQ(reg, 0x8f);
+    reg %= EvFlags{Ev::rxDone, Ev::txDone}.clearUpdate();
+    EXPECT_EQ(reg, 0x8c);
+}
+
+TEST(flags, atomic_event_word)
+{
+    std::atomic<uint8_t> word{0};
+    EvFlags{Ev::rxDone, Ev::error}.setIn(word);
+    EXPECT_EQ(word.load(), 0x21);
+
+    EvFlags(Ev::timeout).setIn(word);
+    EXPECT_TRUE(EvFlags::load(word).test(Ev::timeout));
+
+    auto got = EvFlags::take(word, EvFlags{Ev::error, Ev::timeout});
+    EXPECT_EQ(got.value(), 0xa0);
+    EXPECT_EQ(word.load(), 0x01);
+
+    EvFlags(Ev::rxDone).clearIn(word);
+    EXPECT_EQ(word.load(), 0);
+
+    EvFlags(Ev::txDone).setIn(word);
+    EXPECT_EQ(EvFlags::take(word), EvFlags(Ev::txDone));
+    EXPECT_EQ(word.load(), 0);
+}
+
+TEST(bitops, popCount_ctz)
+{
+    static_assert(bitops::popCount(uint8_t(0xff)) == 8, "");
+    static_assert(bitops::popCount(uint64_t(0xf000000000000001ull)) == 5, "");
+    static_assert(bitops::countTrailingZeros(uint16_t(0x8000)) == 15, "");
+    static_assert(bitops::countTrailingZeros(uint64_t(1ull << 40)) == 40, "");
+    EXPECT_EQ(bitops::popCount(0x12345678u), 13);
+}
+
+int
+main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include "bitops.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+/**
+ * Table driven register initialization.
+ *
+ * An init sequence is a constexpr array of (register address, WordUpdate)
+ * steps. foldInitTable merges consecutive steps to the same register at
+ * compile time, the result is a constant table placed in flash and applied
+ * by a single loop in applyInitTable. Compared to a long chain of inlined
+ * write/update calls this gives less code, and the table itself can be
+ * dumped from the binary and compared offline.
+ *
+ * Steps are merged with WordUpdate::sequence, so a later write to a field
+ * replaces an earlier one. Steps to different registers are never
+ * reordered. A step that defines every bit of its register is applied as a
+ * plain write without reading the register first.
+ *
+ * constexpr bitops::InitStep<uint32_t> clockInit[] = {
+ *     bitops::initStep<RCC::CR>(bitops::set<RCC::CR::HSEON>()),
+ *     bitops::initStep<RCC::CFGR>(bitops::value<RCC::CFGR::SW>(2)),
+ *     bitops::initStep<RCC::CFGR>(bitops::value<RCC::CFGR::PPRE1>(4)),
+ * };
+ * constexpr auto clockTable =
+ *     bitops::foldInitTable<bitops::foldedSize(clockInit)>(clockInit);
+ *
+ * bitops::applyInitTable(clockTable);
+ *
+ * All registers in one table share the same Storage type.
+ */
+
+namespace bitops
+{
+
+/// One step of an init sequence.
+template <typename Storage>
+struct InitStep
+{
+    uintptr_t address = 0;
+    WordUpdate<Storage> wu;
+};
+
+/// Make an init step for a Register type, see register.h.
+template <class Reg>
+constexpr InitStep<typename Reg::RegStorage>
+initStep(const WordUpdate<typename Reg::RegStorage>& wu)
+{
+    static_assert(Reg::Access::writable, "Register is not writable.");
+    InitStep<typename Reg::RegStorage> s;
+    s.address = Reg::address();
+    s.wu = wu;
+    return s;
+}
+
+/// Make an init step for a register given by its address.
+template <typename Storage>
+constexpr InitStep<Storage>
+initStep(uintptr_t address, const WordUpdate<Storage>& wu)
+{
+    InitStep<Storage> s;
+    s.address = address;
+    s.wu = wu;
+    return s;
+}
+
+/// Folded init sequence with exactly 'count' steps.
+template <typename Storage, std::size_t count>
+struct InitTable
+{
+    using Step = InitStep<Storage>;
+
+    constexpr std::size_t size() const
+    {
+        return count;
+    }
+
+    constexpr const Step* begin() const
+    {
+        return steps;
+    }
+
+    constexpr const Step* end() const
+    {
+        return steps + count;
+    }
+
+    Step steps[count];
+};
+
+/// Return number of steps left after merging consecutive steps to the
+/// same register.
+template <typename Storage, std::size_t n>
+constexpr std::size_t
+foldedSize(const InitStep<Storage> (&seq)[n])
+{
+    std::size_t res = 0;
+    for (std::size_t i = 0; i < n; ++i)
+        if (i == 0 || seq[i].address != seq[i - 1].address)
+            ++res;
+    return res;
+}
+
+namespace details
+{
+
+// Not constexpr, so reaching it while folding a constexpr table is a
+// compile error. At runtime it aborts.
+inline void
+initTableSizeMismatch()
+{
+    std::abort();
+}
+} // namespace details
+
+/// Merge consecutive steps to the same register.
+/// 'count' must equal foldedSize(seq), else the fold does not compile
+/// when constant evaluated and aborts at runtime.
+template <std::size_t count, typename Storage, std::size_t n>
+constexpr InitTable<Storage, count>
+foldInitTable(const InitStep<Storage> (&seq)[n])
+{
+    static_assert(count > 0, "Empty init table.");
+    InitTable<Storage, count> res{};
+    std::size_t pos = 0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        if (i != 0 && seq[i].address == seq[i - 1].address)
+        {
+            WordUpdate<Storage>::sequence(res.steps[pos - 1].wu, seq[i].wu);
+        }
+        else
+        {
+            if (pos == count)
+                details::initTableSizeMismatch();
+            res.steps[pos++] = seq[i];
+        }
+    }
+    // Trailing steps would write through address 0.
+    if (pos != count)
+        details::initTableSizeMismatch();
+    return res;
+}
+
+/// Apply init steps in order.
+template <typename Storage>
+void
+applyInitTable(const InitStep<Storage>* first, const InitStep<Storage>* last)
+{
+    const Storage all = static_cast<Storage>(~Storage(0));
+    for (; first != last; ++first)
+    {
+        auto& reg = *reinterpret_cast<volatile Storage*>(first->address);
+        const WordUpdate<Storage>& wu = first->wu;
+        if (static_cast<Storage>(wu.toClear | wu.toSet) == all)
+            reg = wu.toSet;
+        else
+            update(reg, wu);
+    }
+}
+
+template <typename Storage, std::size_t count>
+void
+applyInitTable(const InitTable<Storage, count>& table)
+{
+    applyInitTable(table.begin(), table.end());
+}
+
+} // namespace bitops
@@ -0,0 +1,114 @@
+/*
+ * init_table_test.cpp
+ *
+ *  Tests for table driven register initialization.
+ */
+
+#include "init_table.h"
+#include "register.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+
+struct CR : bitops::Register<uint32_t, 0x40000000u, 0>
+{
+    using EN = bitops::RegField<CR, bool, 0, 1>;
+    using DIV = bitops::RegField<CR, uint32_t, 4, 4>;
+};
+
+struct DR : bitops::Register<uint32_t, 0x40000004u, 0>
+{
+};
+
+using Step = bitops::InitStep<uint32_t>;
+
+constexpr Step seq[] = {
+    bitops::initStep<CR>(bitops::set<CR::EN>()),
+    bitops::initStep<CR>(bitops::value<CR::DIV>(5)),
+    bitops::initStep<DR>(bitops::WordUpdate<uint32_t>(0xffff0000u, 0x1234u)),
+    bitops::initStep<CR>(bitops::value<CR::DIV>(2)),
+    bitops::initStep<CR>(bitops::value<CR::DIV>(9)),
+};
+
+constexpr auto table = bitops::foldInitTable<bitops::foldedSize(seq)>(seq);
+
+#ifdef INIT_TABLE_COUNT_MISMATCH
+// Must not compile, checked by 'make test' with +1 and -1.
+constexpr auto bad = bitops::foldInitTable<bitops::foldedSize(seq) +
+                                           INIT_TABLE_COUNT_MISMATCH>(seq);
+#endif
+
+} // namespace
+
+TEST(WordUpdate, sequence)
+{
+    using WU = bitops::WordUpdate<uint8_t>;
+    // Field written 0b01 and then 0b10. apply would give 0b11.
+    WU a(0x02, 0x01);
+    WU::sequence(a, WU(0x01, 0x02));
+    EXPECT_EQ(a.toClear, 0x03);
+    EXPECT_EQ(a.toSet, 0x02);
+
+    for (unsigned v = 0; v < 256; v += 7)
+    {
+        uint8_t x = v;
+        uint8_t y = v;
+        WU first(0x3c, 0x81);
+        WU second(0x0f, 0x14);
+        x %= first;
+        x %= second;
+        WU::sequence(first, second);
+        y %= first;
+        EXPECT_EQ(x, y);
+    }
+}
+
+TEST(InitTable, fold)
+{
+    static_assert(table.size() == 3, "");
+    static_assert(table.steps[0].address == CR::address(), "");
+    static_assert(table.steps[0].wu.toClear == 0xf0u, "");
+    static_assert(table.steps[0].wu.toSet == 0x51u, "");
+    static_assert(table.steps[1].address == DR::address(), "");
+    static_assert(table.steps[2].wu.toSet == 0x90u, "");
+    static_assert(table.steps[2].wu.toClear == 0xf0u, "");
+}
+
+TEST(InitTable, apply)
+{
+    uint32_t regs[2] = {0xffffff0fu, 0xabcdefffu};
+    auto addr = [&](int i) { return reinterpret_cast<uintptr_t>(&regs[i]); };
+    const Step steps[] = {
+        bitops::initStep(addr(0), bitops::WordUpdate<uint32_t>(0xf0, 0x50)),
+        bitops::initStep(addr(1), bitops::WordUpdate<uint32_t>(0, 0x1)),
+        bitops::initStep(addr(0), bitops::WordUpdate<uint32_t>(0x1, 0)),
+        // Full word write.
+        bitops::initStep(addr(1),
+                         bitops::WordUpdate<uint32_t>(0xffff0000u, 0xffffu)),
+    };
+    bitops::applyInitTable(std::begin(steps), std::end(steps));
+    EXPECT_EQ(regs[0], 0xffffff5eu);
+    EXPECT_EQ(regs[1], 0x0000ffffu);
+}
+
+TEST(InitTable, count_mismatch)
+{
+    // Runtime folds abort instead of leaving steps to address 0.
+    Step copy[5];
+    std::copy(std::begin(seq), std::end(seq), copy);
+    EXPECT_DEATH(bitops::foldInitTable<4>(copy), "");
+    EXPECT_DEATH(bitops::foldInitTable<2>(copy), "");
+    EXPECT_EQ(bitops::foldInitTable<3>(copy).steps[2].wu.toSet, 0x90u);
+}
+
+int
+main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
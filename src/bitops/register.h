@@ -0,0 +1,179 @@
+#pragma once
+
+#include "bitops.h"
+
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * Compile time register descriptions on top of bitops.
+ *
+ * A Register type ties a storage type to a fixed address, a reset value and
+ * an access policy. A RegField type describes one BitField within such a
+ * register. Together they form the 'BitField::Register'/'BitField::Field'
+ * pair expected by bitops::value/set/clear, so all field writes to a register
+ * can be merged into one WordUpdate and applied with a single
+ * read/modify/write.
+ *
+ * These types are normally generated from a CMSIS-SVD file by
+ * tools/svd2bitops.py, but can be written by hand:
+ *
+ * struct CR1 : bitops::Register<uint32_t, 0x4001100c, 0>
+ * {
+ *     using UE = bitops::RegField<CR1, bool, 13, 1>;
+ *     using M = bitops::RegField<CR1, uint32_t, 12, 1>;
+ * };
+ *
+ * bitops::updateRegister<CR1>(bitops::set<CR1::UE>() %
+ *                              bitops::value<CR1::M>(1));
+ */
+
+namespace bitops
+{
+
+/**
+ * Access policies for registers and fields. Matches the SVD access types.
+ */
+namespace access
+{
+struct ReadOnly
+{
+    enum
+    {
+        readable = 1,
+        writable = 0,
+    };
+};
+
+struct WriteOnly
+{
+    enum
+    {
+        readable = 0,
+        writable = 1,
+    };
+};
+
+struct ReadWrite
+{
+    enum
+    {
+        readable = 1,
+        writable = 1,
+    };
+};
+} // namespace access
+
+/**
+ * Description of a memory mapped register.
+ *
+ * @param Storage Integral type of the register.
+ * @param address_ Absolute address of the register.
+ * @param resetValue_ Register content after reset.
+ * @param Access_ One of the access policies.
+ */
+template <typename Storage, uintptr_t address_, Storage resetValue_,
+          class Access_ = access::ReadWrite>
+struct Register
+{
+    using RegStorage = Storage;
+    using Access = Access_;
+
+    static constexpr uintptr_t address()
+    {
+        return address_;
+    }
+
+    static constexpr Storage resetValue()
+    {
+        return resetValue_;
+    }
+
+    /// Return a reference to the hardware register.
+    static volatile Storage& ref()
+    {
+        return *reinterpret_cast<volatile Storage*>(address_);
+    }
+};
+
+/**
+ * Description of a BitField within a Register.
+ *
+ * @param Register_ Register type the field belongs to.
+ * @param FieldType Type representing the field value, typically an enum.
+ * @param offset The bit offset of the field in the register.
+ * @param width The bit width of the field.
+ * @param Access_ Access policy. void means same as the register.
+ */
+template <class Register_, typename FieldType, int offset, int width,
+          class Access_ = void>
+struct RegField
+{
+    using Register = Register_;
+    using Field =
+        BitField<typename Register_::RegStorage, FieldType, offset, width>;
+    using Access = typename std::conditional<std::is_void<Access_>::value,
+                                             typename Register_::Access,
+                                             Access_>::type;
+};
+
+/**
+ * Apply a WordUpdate to a register with a single read/modify/write.
+ * A write only register is written directly, bits not given in the
+ * update are taken from the reset value.
+ */
+template <class Reg>
+void
+updateRegister(const WordUpdate<typename Reg::RegStorage>& wu)
+{
+    static_assert(Reg::Access::writable, "Register is not writable.");
+    if (Reg::Access::readable)
+    {
+        update(Reg::ref(), wu);
+    }
+    else
+    {
+        typename Reg::RegStorage t = Reg::resetValue();
+        update(t, wu);
+        Reg::ref() = t;
+    }
+}
+
+/// Write the reset value to a register.
+template <class Reg>
+void
+resetRegister()
+{
+    static_assert(Reg::Access::writable, "Register is not writable.");
+    Reg::ref() = Reg::resetValue();
+}
+
+/// Write a runtime value into a register field.
+template <class RF>
+void
+writeField(typename RF::Field::FieldType value)
+{
+    static_assert(RF::Access::writable, "Field is not writable.");
+    updateRegister<typename RF::Register>(RF::Field::value(value));
+}
+
+/// Write a compile time value into a register field.
+template <class RF, typename RF::Field::FieldType value>
+void
+writeField()
+{
+    static_assert(RF::Access::writable, "Field is not writable.");
+    updateRegister<typename RF::Register>(
+        RF::Field::template value<value>());
+}
+
+/// Read a field from a register.
+template <class RF>
+typename RF::Field::FieldType
+readField()
+{
+    static_assert(RF::Access::readable, "Field is not readable.");
+    return read<typename RF::Field>(RF::Register::ref());
+}
+
+} // namespace bitops
@@ -0,0 +1,417 @@
+#pragma once
+
+#include "bitops.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Simulated register backend for bitops.
+ *
+ * Driver code written against the bitops API normally operates on a
+ * volatile reference to a hardware register. For Linux hosted testing and
+ * profiling we instead want every access to end up in a model of the
+ * peripheral, and we want to know how many accesses a driver operation
+ * actually generates.
+ *
+ * A sim::Peripheral holds a small register file. sim::Register is a light
+ * handle to one register in it and is accepted by the bitops
+ * 'update'/'write'/'read' functions and by operator %=. Each access is:
+ * - Forwarded to a peripheral model (template argument) that can react to
+ *   writes and supply read values, e.g. status flags or write-1-to-clear.
+ * - Counted per register as a read, a write or a read/modify/write, and
+ *   per field it modifies.
+ * - Appended to a trace with the clear/set masks of the access, which
+ *   allows a compact binary dump.
+ *
+ * Example:
+ *
+ * bitops::sim::Peripheral<uint32_t, 4> usart;
+ * auto cr1 = usart.reg(0);
+ * bitops::write<UeField, 1>(cr1);
+ * EXPECT_EQ(usart.stats(0).rmws, 1);
+ */
+
+namespace bitops
+{
+namespace sim
+{
+
+/// Type of register access stored in the trace.
+enum class Access : uint8_t
+{
+    read = 0,
+    write = 1,
+    rmw = 2,
+};
+
+/**
+ * One recorded access. For reads, 'toSet' holds the value that was read and
+ * 'toClear' is zero. For writes all bits are given, so 'toClear' is the
+ * inverse of the written value.
+ */
+template <typename Storage>
+struct TraceRecord
+{
+    uint16_t reg;
+    Access kind;
+    Storage toClear;
+    Storage toSet;
+
+    /// Mask of the bits this access read or modified.
+    Storage touched() const
+    {
+        return kind == Access::read ? static_cast<Storage>(~Storage(0))
+                                    : static_cast<Storage>(toClear | toSet);
+    }
+};
+
+/// Access counters for one register.
+struct RegStats
+{
+    uint32_t reads = 0;
+    uint32_t writes = 0;
+    uint32_t rmws = 0;
+
+    uint32_t total() const
+    {
+        return reads + writes + rmws;
+    }
+};
+
+/**
+ * Sequence of recorded accesses. Can be serialized into a compact binary
+ * format, one record per access, little endian:
+ * [reg : 2 byte][kind : 1 byte][toClear : sizeof(Storage)][toSet : ditto]
+ */
+template <typename Storage>
+class Trace
+{
+  public:
+    using Record = TraceRecord<Storage>;
+
+    enum
+    {
+        recordSize = 3 + 2 * sizeof(Storage),
+    };
+
+    void add(const Record& r)
+    {
+        if (m_enabled)
+            m_records.push_back(r);
+    }
+
+    void clear()
+    {
+        m_records.clear();
+    }
+
+    // Turn trace recording on/off. Statistics are still collected.
+    void enable(bool en)
+    {
+        m_enabled = en;
+    }
+
+    const std::vector<Record>& records() const
+    {
+        return m_records;
+    }
+
+    /// Count modifying accesses to 'reg' that touch any bit in 'mask'.
+    uint32_t countTouching(int reg, Storage mask) const
+    {
+        uint32_t cnt = 0;
+        for (const auto& r : m_records)
+        {
+            if (r.reg == reg && r.kind != Access::read && (r.touched() & mask))
+                cnt++;
+        }
+        return cnt;
+    }
+
+    /// Return the trace in the binary format described above.
+    std::vector<uint8_t> serialize() const
+    {
+        std::vector<uint8_t> res;
+        res.reserve(m_records.size() * recordSize);
+        for (const auto& r : m_records)
+        {
+            res.push_back(static_cast<uint8_t>(r.reg));
+            res.push_back(static_cast<uint8_t>(r.reg >> 8));
+            res.push_back(static_cast<uint8_t>(r.kind));
+            putLE(res, r.toClear);
+            putLE(res, r.toSet);
+        }
+        return res;
+    }
+
+  private:
+    static void putLE(std::vector<uint8_t>& v, Storage val)
+    {
+        for (std::size_t i = 0; i < sizeof(Storage); ++i)
+            v.push_back(static_cast<uint8_t>(
+                static_cast<uint64_t>(val) >> (8 * i)));
+    }
+
+    std::vector<Record> m_records;
+    bool m_enabled = true;
+};
+
+/**
+ * Default peripheral model. Behaves as plain memory.
+ *
+ * A model may implement:
+ * - onRead(reg, value) : Adjust 'value' before it is returned to the driver.
+ * - onWrite(reg, oldValue, value) : React to a write. May modify 'value'
+ *   which is the new content stored in the register.
+ */
+struct MemoryModel
+{
+    template <typename Storage>
+    void onRead(int, Storage&)
+    {
+    }
+
+    template <typename Storage>
+    void onWrite(int, Storage, Storage&)
+    {
+    }
+};
+
+template <class Peripheral>
+class Register;
+
+/**
+ * A simulated peripheral with 'regNo' registers of type Storage.
+ * Register accesses are routed to the model, counted and traced.
+ * The model is inherited privately, similar to isr::cover, to allow
+ * empty models to take no space.
+ */
+template <typename Storage_, int regNo, class Model = MemoryModel>
+class Peripheral : private Model
+{
+  public:
+    using Storage = Storage_;
+    using Reg = Register<Peripheral>;
+
+    explicit Peripheral(Storage resetValue = 0)
+    {
+        m_regs.fill(resetValue);
+    }
+
+    /// Traced read of a register.
+    Storage read(int reg)
+    {
+        Storage v = m_regs[reg];
+        Model::onRead(reg, v);
+        m_stats[reg].reads++;
+        m_trace.add({static_cast<uint16_t>(reg), Access::read, 0, v});
+        return v;
+    }
+
+    /// Traced write of a full register value.
+    void write(int reg, Storage value)
+    {
+        store(reg, value);
+        m_stats[reg].writes++;
+        countTouched(reg, static_cast<Storage>(~Storage(0)));
+        m_trace.add({static_cast<uint16_t>(reg), Access::write,
+                     static_cast<Storage>(~value), value});
+    }
+
+    /// Traced read/modify/write of a register.
+    void update(int reg, const WordUpdate<Storage>& wu)
+    {
+        Storage v = m_regs[reg];
+        Model::onRead(reg, v);
+        bitops::update(v, wu);
+        store(reg, v);
+        m_stats[reg].rmws++;
+        countTouched(reg, static_cast<Storage>(wu.toClear | wu.toSet));
+        m_trace.add({static_cast<uint16_t>(reg), Access::rmw, wu.toClear,
+                     wu.toSet});
+    }
+
+    /// Untraced access to the register content, e.g. for test setup.
+    Storage& raw(int reg)
+    {
+        return m_regs[reg];
+    }
+
+    Reg reg(int reg)
+    {
+        return Reg(*this, reg);
+    }
+
+    const RegStats& stats(int reg) const
+    {
+        return m_stats[reg];
+    }
+
+    /// Sum of the statistics for all registers.
+    RegStats totalStats() const
+    {
+        RegStats res;
+        for (const auto& s : m_stats)
+        {
+            res.reads += s.reads;
+            res.writes += s.writes;
+            res.rmws += s.rmws;
+        }
+        return res;
+    }
+
+    /// Number of modifying accesses to 'reg' that touched the field.
+    /// Counted also while trace recording is disabled.
+    template <typename BitField>
+    uint32_t fieldAccesses(int reg) const
+    {
+        const Storage mask = bitFieldMask<BitField>();
+        uint32_t cnt = 0;
+        for (const auto& t : m_touched[reg])
+            if (t.mask & mask)
+                cnt += t.count;
+        return cnt;
+    }
+
+    /// Clear statistics and trace. Register content is kept.
+    void resetStats()
+    {
+        m_stats.fill(RegStats());
+        for (auto& t : m_touched)
+            t.clear();
+        m_trace.clear();
+    }
+
+    Trace<Storage>& trace()
+    {
+        return m_trace;
+    }
+
+    const Trace<Storage>& trace() const
+    {
+        return m_trace;
+    }
+
+    Model& model()
+    {
+        return static_cast<Model&>(*this);
+    }
+
+  private:
+    // Number of modifying accesses with a given touched mask. Drivers use
+    // few distinct masks per register, so a short list is enough.
+    struct TouchCount
+    {
+        Storage mask;
+        uint32_t count;
+    };
+
+    void store(int reg, Storage value)
+    {
+        Model::onWrite(reg, m_regs[reg], value);
+        m_regs[reg] = value;
+    }
+
+    void countTouched(int reg, Storage mask)
+    {
+        for (auto& t : m_touched[reg])
+        {
+            if (t.mask == mask)
+            {
+                t.count++;
+                return;
+            }
+        }
+        m_touched[reg].push_back({mask, 1});
+    }
+
+    std::array<Storage, regNo> m_regs;
+    std::array<RegStats, regNo> m_stats;
+    std::array<std::vector<TouchCount>, regNo> m_touched;
+    Trace<Storage> m_trace;
+};
+
+/**
+ * Handle to one register in a simulated peripheral. Cheap to copy,
+ * pass it where driver code would use a register reference.
+ */
+template <class Peripheral>
+class Register
+{
+  public:
+    Register(Peripheral& p, int reg) : m_periph(&p), m_reg(reg) {}
+
+    Peripheral& peripheral() const
+    {
+        return *m_periph;
+    }
+
+    int index() const
+    {
+        return m_reg;
+    }
+
+  private:
+    Peripheral* m_periph;
+    int m_reg;
+};
+
+} // namespace sim
+
+/**
+ * Apply a WordUpdate to a simulated register. One traced read/modify/write.
+ */
+template <class Peripheral, class Storage>
+void
+update(sim::Register<Peripheral> r, const WordUpdate<Storage>& wu)
+{
+    r.peripheral().update(r.index(), wu);
+}
+
+template <class Storage, class Peripheral>
+void
+write(sim::Register<Peripheral> r, const WordUpdate<Storage>& wu)
+{
+    r.peripheral().update(r.index(), wu);
+}
+
+/**
+ * Write a BitField value into a simulated register.
+ * @tparam BitField Type of the BitField.
+ * @param r Register handle.
+ * @param value Value to be written.
+ */
+template <typename BitField, class Peripheral>
+void
+write(sim::Register<Peripheral> r, typename BitField::FieldType value)
+{
+    r.peripheral().update(r.index(), BitField::value(value));
+}
+
+template <typename BitField, typename BitField::FieldType value,
+          class Peripheral>
+void
+write(sim::Register<Peripheral> r)
+{
+    r.peripheral().update(r.index(), BitField::template value<value>());
+}
+
+template <typename BitField, class Peripheral>
+typename BitField::FieldType
+read(sim::Register<Peripheral> r)
+{
+    return read<BitField>(r.peripheral().read(r.index()));
+}
+
+template <class Peripheral, class Storage>
+sim::Register<Peripheral>
+operator%=(sim::Register<Peripheral> lhs, const WordUpdate<Storage>& rhs)
+{
+    update(lhs, rhs);
+    return lhs;
+}
+
+} // namespace bitops
@@ -0,0 +1,168 @@
+/*
+ * regsim_test.cpp
+ *
+ *  Tests for the simulated register backend.
+ */
+
+#include "regsim.h"
+
+#include <gtest/gtest.h>
+
+namespace
+{
+
+enum class Mode
+{
+    off = 0,
+    slow = 1,
+    fast = 2,
+    turbo = 3,
+};
+
+using EnField = bitops::BitField<uint32_t, int, 0, 1>;
+using ModeField = bitops::BitField<uint32_t, Mode, 4, 2>;
+using DivField = bitops::BitField<uint32_t, int, 8, 8>;
+
+// Model a peripheral with a status register (1) where writing '1' clears
+// the flag, and a data register (2) that always read back as 0x55.
+struct W1cModel
+{
+    template <typename Storage>
+    void onRead(int reg, Storage& value)
+    {
+        if (reg == 2)
+            value = 0x55;
+    }
+
+    template <typename Storage>
+    void onWrite(int reg, Storage oldValue, Storage& value)
+    {
+        if (reg == 1)
+            value = oldValue & ~value;
+        writes++;
+    }
+    int writes = 0;
+};
+
+} // namespace
+
+TEST(regsim, write_bitfield)
+{
+    bitops::sim::Peripheral<uint32_t, 4> periph;
+    auto cr = periph.reg(0);
+
+    bitops::write<ModeField>(cr, Mode::fast);
+    EXPECT_EQ(periph.raw(0), 0x20u);
+    EXPECT_EQ(bitops::read<ModeField>(cr), Mode::fast);
+
+    bitops::write<EnField, 1>(cr);
+    EXPECT_EQ(periph.raw(0), 0x21u);
+
+    const auto& st = periph.stats(0);
+    EXPECT_EQ(st.rmws, 2u);
+    EXPECT_EQ(st.reads, 1u);
+    EXPECT_EQ(st.writes, 0u);
+    EXPECT_EQ(periph.stats(1).total(), 0u);
+}
+
+TEST(regsim, merged_update_is_one_rmw)
+{
+    bitops::sim::Peripheral<uint32_t, 4> periph;
+    auto cr = periph.reg(3);
+
+    // Three separate writes.
+    bitops::write<ModeField>(cr, Mode::slow);
+    bitops::write<DivField>(cr, 7);
+    bitops::write<EnField, 1>(cr);
+    EXPECT_EQ(periph.stats(3).rmws, 3u);
+    uint32_t separate = periph.raw(3);
+
+    // Same result merged into one access.
+    periph.raw(3) = 0;
+    periph.resetStats();
+    cr %= ModeField::value(Mode::slow) % DivField::value(7) %
+          EnField::value<1>();
+    EXPECT_EQ(periph.stats(3).rmws, 1u);
+    EXPECT_EQ(periph.raw(3), separate);
+    EXPECT_EQ(periph.totalStats().total(), 1u);
+}
+
+TEST(regsim, field_accesses)
+{
+    bitops::sim::Peripheral<uint32_t, 2> periph;
+    auto r = periph.reg(1);
+
+    bitops::write<ModeField>(r, Mode::turbo);
+    bitops::write<DivField>(r, 3);
+    bitops::write<ModeField>(r, Mode::off);
+    bitops::update(r, bitops::WordUpdate<uint32_t>().setBit(0));
+
+    EXPECT_EQ(periph.fieldAccesses<ModeField>(1), 2u);
+    EXPECT_EQ(periph.fieldAccesses<DivField>(1), 1u);
+    EXPECT_EQ(periph.fieldAccesses<EnField>(1), 1u);
+    EXPECT_EQ(periph.fieldAccesses<ModeField>(0), 0u);
+
+    // Counted without trace recording too.
+    periph.trace().enable(false);
+    bitops::write<DivField>(r, 4);
+    periph.write(1, 0);
+    EXPECT_EQ(periph.fieldAccesses<DivField>(1), 3u);
+    EXPECT_EQ(periph.fieldAccesses<ModeField>(1), 3u);
+
+    periph.resetStats();
+    EXPECT_EQ(periph.fieldAccesses<DivField>(1), 0u);
+}
+
+TEST(regsim, model_hooks)
+{
+    bitops::sim::Peripheral<uint32_t, 3, W1cModel> periph;
+    periph.raw(1) = 0x0f;
+
+    periph.write(1, 0x05);
+    EXPECT_EQ(periph.raw(1), 0x0au);
+    EXPECT_EQ(periph.read(2), 0x55u);
+    EXPECT_EQ(periph.model().writes, 1);
+
+    // A read/modify/write on a w1c register clears the bits that read as set.
+    auto r = periph.reg(1);
+    bitops::write<EnField, 0>(r);
+    EXPECT_EQ(periph.raw(1), 0x0u);
+    EXPECT_EQ(periph.model().writes, 2);
+}
+
+TEST(regsim, binary_trace)
+{
+    bitops::sim::Peripheral<uint16_t, 2> periph;
+    periph.write(1, 0x1234);
+    periph.read(1);
+
+    auto bytes = periph.trace().serialize();
+    using Trace = bitops::sim::Trace<uint16_t>;
+    ASSERT_EQ(bytes.size(), 2 * Trace::recordSize);
+    EXPECT_EQ(int(Trace::recordSize), 7);
+
+    // First record: write of 0x1234 to register 1.
+    EXPECT_EQ(bytes[0], 1);
+    EXPECT_EQ(bytes[1], 0);
+    EXPECT_EQ(bytes[2], uint8_t(bitops::sim::Access::write));
+    EXPECT_EQ(bytes[3], 0xcb);
+    EXPECT_EQ(bytes[4], 0xed);
+    EXPECT_EQ(bytes[5], 0x34);
+    EXPECT_EQ(bytes[6], 0x12);
+
+    // Second record: read.
+    EXPECT_EQ(bytes[9], uint8_t(bitops::sim::Access::read));
+    EXPECT_EQ(bytes[12], 0x34);
+
+    periph.trace().enable(false);
+    periph.read(1);
+    EXPECT_EQ(periph.trace().records().size(), 2u);
+    EXPECT_EQ(periph.stats(1).reads, 2u);
+}
+
+int
+main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,232 @@
+#pragma once
+
+#include "bitops.h"
+#include "init_table.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Write combining register transactions.
+ *
+ * A transaction collects field writes for one register and applies them
+ * with a single read/modify/write, either on commit() or when it goes out
+ * of scope. Useful when field values are only known at runtime, where a
+ * sequence of write<BitField>(reg, v) calls would give one volatile
+ * read/modify/write each.
+ *
+ * {
+ *     auto t = bitops::make_transaction(USART1->CR1);
+ *     t.write<CR1_M>(wordLength);
+ *     t.write<CR1_PCE>(parity);
+ *     t %= stopBitsUpdate;
+ * } // One read/modify/write here.
+ *
+ * Updates are merged with WordUpdate::sequence, so writing a field twice
+ * keeps the last value.
+ *
+ * multi_transaction does the same for several registers and writes them in
+ * increasing address order.
+ */
+
+namespace bitops
+{
+
+/**
+ * @param Storage Integral type of the register.
+ * @param Target Register reference, anything accepted by bitops::update.
+ */
+template <typename Storage, class Target = volatile Storage&>
+class transaction
+{
+  public:
+    explicit transaction(Target target) : m_target(target) {}
+
+    transaction(transaction&& other)
+        : m_target(other.m_target), m_wu(other.m_wu),
+          m_pending(other.m_pending)
+    {
+        other.m_pending = false;
+    }
+
+    transaction(const transaction&) = delete;
+    transaction& operator=(const transaction&) = delete;
+
+    ~transaction()
+    {
+        commit();
+    }
+
+    /// Add an update, applied after the ones already added.
+    transaction& operator%=(const WordUpdate<Storage>& wu)
+    {
+        WordUpdate<Storage>::sequence(m_wu, wu);
+        m_pending = true;
+        return *this;
+    }
+
+    /// Add a runtime field write.
+    template <typename BitField>
+    transaction& write(typename BitField::FieldType value)
+    {
+        return *this %= BitField::value(value);
+    }
+
+    /// Add a compile time field write.
+    template <typename BitField, typename BitField::FieldType value>
+    transaction& write()
+    {
+        return *this %= BitField::template value<value>();
+    }
+
+    /// Apply collected updates now. Does nothing if none are pending.
+    void commit()
+    {
+        if (m_pending)
+        {
+            update(m_target, m_wu);
+            cancel();
+        }
+    }
+
+    /// Drop collected updates.
+    void cancel()
+    {
+        m_wu = WordUpdate<Storage>();
+        m_pending = false;
+    }
+
+    bool pending() const
+    {
+        return m_pending;
+    }
+
+    /// Merged update that commit() will apply.
+    const WordUpdate<Storage>& wordUpdate() const
+    {
+        return m_wu;
+    }
+
+  private:
+    Target m_target;
+    WordUpdate<Storage> m_wu;
+    bool m_pending = false;
+};
+
+/// Start a transaction on a register reference.
+template <typename Storage>
+transaction<Storage>
+make_transaction(volatile Storage& reg)
+{
+    return transaction<Storage>(reg);
+}
+
+/// Start a transaction on a Register type, see register.h.
+template <class Reg>
+transaction<typename Reg::RegStorage>
+make_transaction()
+{
+    static_assert(Reg::Access::readable && Reg::Access::writable,
+                  "Transaction needs a read/write register.");
+    return transaction<typename Reg::RegStorage>(Reg::ref());
+}
+
+/**
+ * Transaction over up to 'maxRegs' registers. On commit, each register is
+ * updated once in increasing address order. A register whose every bit is
+ * given is written without a read.
+ *
+ * Adding more than maxRegs registers is an error: the update is dropped,
+ * overflowed() turns true and commit() then writes nothing, so a
+ * reconfiguration is never applied half way or out of order. Size
+ * maxRegs for the largest transaction used.
+ */
+template <typename Storage, std::size_t maxRegs>
+class multi_transaction
+{
+  public:
+    multi_transaction() = default;
+    multi_transaction(const multi_transaction&) = delete;
+    multi_transaction& operator=(const multi_transaction&) = delete;
+
+    ~multi_transaction()
+    {
+        commit();
+    }
+
+    /// Add an update to the register at 'address'.
+    multi_transaction& add(uintptr_t address, const WordUpdate<Storage>& wu)
+    {
+        // Entries are kept sorted on address.
+        std::size_t i = 0;
+        while (i < m_count && m_steps[i].address < address)
+            ++i;
+        if (i < m_count && m_steps[i].address == address)
+        {
+            WordUpdate<Storage>::sequence(m_steps[i].wu, wu);
+            return *this;
+        }
+        if (m_count == maxRegs)
+        {
+            m_overflow = true;
+            return *this;
+        }
+        for (std::size_t j = m_count; j > i; --j)
+            m_steps[j] = m_steps[j - 1];
+        m_steps[i] = initStep(address, wu);
+        ++m_count;
+        return *this;
+    }
+
+    multi_transaction& add(volatile Storage& reg,
+                           const WordUpdate<Storage>& wu)
+    {
+        return add(reinterpret_cast<uintptr_t>(&reg), wu);
+    }
+
+    /// Add an update to a Register type, see register.h.
+    template <class Reg>
+    multi_transaction& add(const WordUpdate<Storage>& wu)
+    {
+        static_assert(Reg::Access::readable && Reg::Access::writable,
+                      "Transaction needs a read/write register.");
+        return add(Reg::address(), wu);
+    }
+
+    /// Apply all pending updates. Returns false, writing nothing, if
+    /// registers were dropped on overflow.
+    bool commit()
+    {
+        const bool ok = !m_overflow;
+        if (ok)
+            applyInitTable(m_steps, m_steps + m_count);
+        cancel();
+        return ok;
+    }
+
+    /// Drop pending updates and clear the overflow.
+    void cancel()
+    {
+        m_count = 0;
+        m_overflow = false;
+    }
+
+    /// True if an add() was dropped since the last commit or cancel.
+    bool overflowed() const
+    {
+        return m_overflow;
+    }
+
+    /// Number of registers with pending updates.
+    std::size_t pending() const
+    {
+        return m_count;
+    }
+
+  private:
+    InitStep<Storage> m_steps[maxRegs];
+    std::size_t m_count = 0;
+    bool m_overflow = false;
+};
+
+} // namespace bitops
@@ -0,0 +1,116 @@
+/*
+ * transaction_test.cpp
+ *
+ *  Tests for write combining register transactions.
+ */
+
+#include "transaction.h"
+#include "regsim.h"
+
+#include <gtest/gtest.h>
+
+namespace
+{
+
+using EnField = bitops::BitField<uint32_t, int, 0, 1>;
+using DivField = bitops::BitField<uint32_t, int, 8, 8>;
+
+using Periph = bitops::sim::Peripheral<uint32_t, 2>;
+using SimTransaction = bitops::transaction<uint32_t, Periph::Reg>;
+
+} // namespace
+
+TEST(transaction, one_rmw_on_scope_exit)
+{
+    Periph periph(0xff00u);
+    {
+        SimTransaction t(periph.reg(0));
+        t.write<DivField>(3);
+        t.write<EnField, 1>();
+        t.write<DivField>(5); // Last write wins.
+        EXPECT_TRUE(t.pending());
+        EXPECT_EQ(periph.stats(0).total(), 0u);
+    }
+    EXPECT_EQ(periph.raw(0), 0x0501u);
+    EXPECT_EQ(periph.stats(0).rmws, 1u);
+    EXPECT_EQ(periph.totalStats().total(), 1u);
+}
+
+TEST(transaction, commit_and_cancel)
+{
+    Periph periph;
+    SimTransaction t(periph.reg(1));
+    t.commit();
+    EXPECT_EQ(periph.stats(1).total(), 0u);
+
+    t %= EnField::set();
+    t.commit();
+    EXPECT_FALSE(t.pending());
+    EXPECT_EQ(periph.raw(1), 1u);
+
+    t.write<DivField>(9);
+    t.cancel();
+    t.commit();
+    EXPECT_EQ(periph.raw(1), 1u);
+    EXPECT_EQ(periph.stats(1).rmws, 1u);
+}
+
+TEST(transaction, volatile_reference)
+{
+    volatile uint32_t reg = 0xffffffffu;
+    {
+        auto t = bitops::make_transaction(reg);
+        t.write<EnField, 0>();
+        t.write<DivField>(0x12);
+        EXPECT_EQ(reg, 0xffffffffu);
+    }
+    EXPECT_EQ(reg, 0xffff12feu);
+}
+
+TEST(multi_transaction, address_order)
+{
+    volatile uint32_t regs[3] = {0, 0, 0x10};
+    {
+        bitops::multi_transaction<uint32_t, 3> t;
+        t.add(regs[2], EnField::set());
+        t.add(regs[0], DivField::value(1));
+        t.add(regs[2], DivField::value(2));
+        EXPECT_EQ(t.pending(), 2u);
+        EXPECT_EQ(regs[2], 0x10u);
+    }
+    EXPECT_EQ(regs[0], 0x100u);
+    EXPECT_EQ(regs[1], 0u);
+    EXPECT_EQ(regs[2], 0x211u);
+}
+
+TEST(multi_transaction, overflow_writes_nothing)
+{
+    volatile uint32_t regs[3] = {0, 0, 0};
+    bitops::multi_transaction<uint32_t, 2> t;
+    t.add(regs[1], EnField::set());
+    t.add(regs[0], EnField::set());
+    EXPECT_FALSE(t.overflowed());
+    t.add(regs[2], EnField::set());
+    EXPECT_TRUE(t.overflowed());
+    EXPECT_EQ(t.pending(), 2u);
+    EXPECT_EQ(regs[0], 0u);
+
+    // Existing registers can still be merged, but commit refuses.
+    t.add(regs[0], DivField::value(1));
+    EXPECT_FALSE(t.commit());
+    EXPECT_EQ(regs[0], 0u);
+    EXPECT_EQ(regs[1], 0u);
+    EXPECT_EQ(regs[2], 0u);
+    EXPECT_FALSE(t.overflowed());
+
+    t.add(regs[2], EnField::set());
+    EXPECT_TRUE(t.commit());
+    EXPECT_EQ(regs[2], 1u);
+}
+
+int
+main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
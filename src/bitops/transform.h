@@ -0,0 +1,293 @@
+#pragma once
+
+#include "bitops.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
+/**
+ * Bit order and byte order transforms, for single values and for whole
+ * buffers, e.g. before handing a buffer to an LSB first SPI or to a DMA
+ * channel feeding a peripheral with the other endianness.
+ *
+ * Single value versions are constexpr. See also byteSwap and reverseBits
+ * in bitops.h.
+ *
+ * Buffer versions take a destination and a source, which may be the same
+ * buffer. With SSSE3 or AVX2 enabled they use byte shuffles, 16 or 32
+ * bytes at a time. Otherwise they work a word at a time with shifts and
+ * masks. Buffers need no particular alignment.
+ *
+ * Interleave/deinterleave convert between one buffer per channel and a
+ * buffer with the channels interleaved, e.g. stereo audio.
+ */
+
+namespace bitops
+{
+
+/// Swap the two nibbles within each byte of value.
+template <typename Storage>
+constexpr Storage
+nibbleSwap(Storage value)
+{
+    using U = unsigned long long;
+    const U m4 = 0x0f0f0f0f0f0f0f0full;
+    U v = static_cast<U>(value);
+    return static_cast<Storage>(((v >> 4) & m4) | ((v & m4) << 4));
+}
+
+/// Reverse the bit order within each byte of value, keeping byte order.
+template <typename Storage>
+constexpr Storage
+reverseBitsInBytes(Storage value)
+{
+    return reverseBits(byteSwap(value));
+}
+
+namespace details
+{
+
+enum class ByteOp
+{
+    none,
+    reverseBits,
+    nibbleSwap,
+};
+
+template <ByteOp op, typename Word>
+constexpr Word
+byteOp(Word w)
+{
+    return op == ByteOp::reverseBits
+               ? reverseBitsInBytes(w)
+               : op == ByteOp::nibbleSwap ? nibbleSwap(w) : w;
+}
+
+#if defined(__SSSE3__)
+// Shuffle mask reversing byte order within each group of wordSize bytes.
+template <int wordSize>
+inline __m128i
+byteSwapMask()
+{
+    alignas(16) uint8_t m[16];
+    for (int i = 0; i < 16; ++i)
+        m[i] = static_cast<uint8_t>(i / wordSize * wordSize +
+                                    (wordSize - 1 - i % wordSize));
+    return _mm_load_si128(reinterpret_cast<const __m128i*>(m));
+}
+
+// Apply op to every byte of v, using nibble lookups.
+template <ByteOp op>
+inline __m128i
+byteOp128(__m128i v)
+{
+    if (op == ByteOp::none)
+        return v;
+    const __m128i low = _mm_set1_epi8(0x0f);
+    __m128i lo = _mm_and_si128(v, low);
+    __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), low);
+    if (op == ByteOp::reverseBits)
+    {
+        const __m128i rev = _mm_setr_epi8(0, 8, 4, 12, 2, 10, 6, 14, 1, 9,
+                                          5, 13, 3, 11, 7, 15);
+        lo = _mm_shuffle_epi8(rev, lo);
+        hi = _mm_shuffle_epi8(rev, hi);
+    }
+    return _mm_or_si128(_mm_slli_epi16(lo, 4), hi);
+}
+
+#if defined(__AVX2__)
+template <ByteOp op>
+inline __m256i
+byteOp256(__m256i v)
+{
+    if (op == ByteOp::none)
+        return v;
+    const __m256i low = _mm256_set1_epi8(0x0f);
+    __m256i lo = _mm256_and_si256(v, low);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low);
+    if (op == ByteOp::reverseBits)
+    {
+        const __m256i rev = _mm256_setr_epi8(
+            0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15, 0, 8, 4, 12,
+            2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15);
+        lo = _mm256_shuffle_epi8(rev, lo);
+        hi = _mm256_shuffle_epi8(rev, hi);
+    }
+    return _mm256_or_si256(_mm256_slli_epi16(lo, 4), hi);
+}
+#endif
+
+// Transform whole 16 (32 with AVX2) byte blocks. Return bytes processed.
+template <int wordSize, ByteOp op>
+inline std::size_t
+vectorTransform(uint8_t* dst, const uint8_t* src, std::size_t len)
+{
+    const __m128i mask = byteSwapMask<wordSize>();
+    std::size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i mask2 = _mm256_broadcastsi128_si256(mask);
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i v =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        if (wordSize > 1)
+            v = _mm256_shuffle_epi8(v, mask2);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                            byteOp256<op>(v));
+    }
+#endif
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        if (wordSize > 1)
+            v = _mm_shuffle_epi8(v, mask);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                         byteOp128<op>(v));
+    }
+    return i;
+}
+#endif
+
+// Byte swap each Word (if swap) and apply op to each byte, for 'count'
+// words. Word is the unit used for the scalar path.
+template <typename Word, bool swap, ByteOp op>
+inline void
+transformWords(uint8_t* dst, const uint8_t* src, std::size_t count)
+{
+    std::size_t done = 0;
+#if defined(__SSSE3__)
+    done = vectorTransform<swap ? sizeof(Word) : 1, op>(
+               dst, src, count * sizeof(Word)) /
+           sizeof(Word);
+#endif
+    for (std::size_t i = done; i < count; ++i)
+    {
+        Word w;
+        std::memcpy(&w, src + i * sizeof(Word), sizeof(Word));
+        if (swap)
+            w = byteSwap(w);
+        w = byteOp<op>(w);
+        std::memcpy(dst + i * sizeof(Word), &w, sizeof(Word));
+    }
+}
+
+// Apply op to each of 'len' bytes, 8 bytes at a time where possible.
+template <ByteOp op>
+inline void
+transformBytes(uint8_t* dst, const uint8_t* src, std::size_t len)
+{
+    transformWords<uint64_t, false, op>(dst, src, len / 8);
+    std::size_t tail = len & ~std::size_t(7);
+    transformWords<uint8_t, false, op>(dst + tail, src + tail, len - tail);
+}
+
+} // namespace details
+
+/// Reverse the bit order of each byte in a buffer.
+inline void
+reverseBitsInBytes(uint8_t* dst, const uint8_t* src, std::size_t len)
+{
+    details::transformBytes<details::ByteOp::reverseBits>(dst, src, len);
+}
+
+/// Swap the nibbles of each byte in a buffer.
+inline void
+nibbleSwap(uint8_t* dst, const uint8_t* src, std::size_t len)
+{
+    details::transformBytes<details::ByteOp::nibbleSwap>(dst, src, len);
+}
+
+/// Reverse the byte order of each of 'count' words in a buffer.
+template <typename Word>
+void
+byteSwap(Word* dst, const Word* src, std::size_t count)
+{
+    details::transformWords<Word, true, details::ByteOp::none>(
+        reinterpret_cast<uint8_t*>(dst),
+        reinterpret_cast<const uint8_t*>(src), count);
+}
+
+/// Reverse the bit order of each of 'count' words in a buffer.
+template <typename Word>
+void
+reverseBits(Word* dst, const Word* src, std::size_t count)
+{
+    details::transformWords<Word, true, details::ByteOp::reverseBits>(
+        reinterpret_cast<uint8_t*>(dst),
+        reinterpret_cast<const uint8_t*>(src), count);
+}
+
+/**
+ * Interleave 'channels' buffers of 'frames' samples each into dst,
+ * giving ch0[0], ch1[0], ..., ch0[1], ch1[1], ...
+ */
+template <typename T>
+void
+interleave(T* dst, const T* const* channels, int channelCount,
+           std::size_t frames)
+{
+    std::size_t f = 0;
+#if defined(__SSSE3__)
+    if (sizeof(T) == 2 && channelCount == 2)
+    {
+        // Stereo 16 bit, the common audio case.
+        const T* l = channels[0];
+        const T* r = channels[1];
+        for (; f + 8 <= frames; f += 8)
+        {
+            __m128i a =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(l + f));
+            __m128i b =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(r + f));
+            auto out = reinterpret_cast<__m128i*>(dst + 2 * f);
+            _mm_storeu_si128(out, _mm_unpacklo_epi16(a, b));
+            _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(a, b));
+        }
+    }
+#endif
+    for (; f < frames; ++f)
+        for (int c = 0; c < channelCount; ++c)
+            dst[f * channelCount + c] = channels[c][f];
+}
+
+/**
+ * Split interleaved src into 'channels' buffers of 'frames' samples each.
+ */
+template <typename T>
+void
+deinterleave(T* const* channels, const T* src, int channelCount,
+             std::size_t frames)
+{
+    std::size_t f = 0;
+#if defined(__SSSE3__)
+    if (sizeof(T) == 2 && channelCount == 2)
+    {
+        // Gather even samples into the low half, odd into the high half.
+        const __m128i split = _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, 2, 3,
+                                            6, 7, 10, 11, 14, 15);
+        T* l = channels[0];
+        T* r = channels[1];
+        for (; f + 8 <= frames; f += 8)
+        {
+            auto in = reinterpret_cast<const __m128i*>(src + 2 * f);
+            __m128i a = _mm_shuffle_epi8(_mm_loadu_si128(in), split);
+            __m128i b = _mm_shuffle_epi8(_mm_loadu_si128(in + 1), split);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(l + f),
+                             _mm_unpacklo_epi64(a, b));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(r + f),
+                             _mm_unpackhi_epi64(a, b));
+        }
+    }
+#endif
+    for (; f < frames; ++f)
+        for (int c = 0; c < channelCount; ++c)
+            channels[c][f] = src[f * channelCount + c];
+}
+
+} // namespace bitops
@@ -0,0 +1,135 @@
+/*
+ * transform_test.cpp
+ *
+ *  Tests for bit and byte order transforms.
+ */
+
+#include "transform.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace
+{
+
+std::vector<uint8_t>
+testData(std::size_t len)
+{
+    std::vector<uint8_t> res(len);
+    uint32_t x = 1;
+    for (auto& d : res)
+    {
+        x = x * 1103515245u + 12345u;
+        d = static_cast<uint8_t>(x >> 16);
+    }
+    return res;
+}
+
+// Lengths covering empty, scalar tails and several vector blocks.
+const std::size_t lengths[] = {0, 1, 7, 15, 16, 17, 31, 32, 33, 100, 257};
+
+} // namespace
+
+TEST(transform, single_value)
+{
+    static_assert(bitops::nibbleSwap(uint8_t(0x1f)) == 0xf1, "");
+    static_assert(bitops::nibbleSwap(0x12345678u) == 0x21436587u, "");
+    static_assert(bitops::reverseBitsInBytes(uint16_t(0x0180)) == 0x8001, "");
+    static_assert(bitops::reverseBitsInBytes(0x01020304u) == 0x8040c020u, "");
+}
+
+TEST(transform, bytes)
+{
+    for (std::size_t len : lengths)
+    {
+        auto src = testData(len + 1);
+        std::vector<uint8_t> dst(len + 1, 0xaa);
+        // Offset by one to test unaligned access.
+        bitops::reverseBitsInBytes(dst.data() + 1, src.data() + 1, len);
+        for (std::size_t i = 1; i <= len; ++i)
+            ASSERT_EQ(dst[i], bitops::reverseBits(src[i])) << len;
+        EXPECT_EQ(dst[0], 0xaa);
+
+        bitops::nibbleSwap(dst.data(), src.data(), len);
+        for (std::size_t i = 0; i < len; ++i)
+            ASSERT_EQ(dst[i], bitops::nibbleSwap(src[i])) << len;
+    }
+}
+
+template <typename Word>
+void
+checkWords()
+{
+    for (std::size_t count : lengths)
+    {
+        auto bytes = testData(count * sizeof(Word));
+        std::vector<Word> src(count);
+        if (count)
+            std::memcpy(src.data(), bytes.data(), bytes.size());
+        std::vector<Word> dst(count);
+        bitops::byteSwap(dst.data(), src.data(), count);
+        for (std::size_t i = 0; i < count; ++i)
+            ASSERT_EQ(dst[i], bitops::byteSwap(src[i])) << count;
+
+        bitops::reverseBits(dst.data(), src.data(), count);
+        for (std::size_t i = 0; i < count; ++i)
+            ASSERT_EQ(dst[i], bitops::reverseBits(src[i])) << count;
+
+        // In place.
+        bitops::reverseBits(src.data(), src.data(), count);
+        EXPECT_EQ(src, dst);
+    }
+}
+
+TEST(transform, words)
+{
+    checkWords<uint16_t>();
+    checkWords<uint32_t>();
+    checkWords<uint64_t>();
+}
+
+template <typename T>
+void
+checkInterleave(int channelCount)
+{
+    for (std::size_t frames : lengths)
+    {
+        std::vector<std::vector<T>> ch(channelCount, std::vector<T>(frames));
+        std::vector<T*> ptrs;
+        for (int c = 0; c < channelCount; ++c)
+        {
+            for (std::size_t f = 0; f < frames; ++f)
+                ch[c][f] = static_cast<T>(f * 16 + c);
+            ptrs.push_back(ch[c].data());
+        }
+        std::vector<T> mixed(frames * channelCount);
+        bitops::interleave<T>(mixed.data(), ptrs.data(), channelCount, frames);
+        for (std::size_t i = 0; i < mixed.size(); ++i)
+            ASSERT_EQ(mixed[i], static_cast<T>(i / channelCount * 16 +
+                                               i % channelCount));
+
+        std::vector<std::vector<T>> back(channelCount, std::vector<T>(frames));
+        std::vector<T*> backPtrs;
+        for (auto& b : back)
+            backPtrs.push_back(b.data());
+        bitops::deinterleave<T>(backPtrs.data(), mixed.data(), channelCount,
+                                frames);
+        EXPECT_EQ(back, ch);
+    }
+}
+
+TEST(transform, interleave)
+{
+    checkInterleave<uint16_t>(2);
+    checkInterleave<uint16_t>(3);
+    checkInterleave<int32_t>(2);
+    checkInterleave<uint8_t>(4);
+}
+
+int
+main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,227 @@
+/*
+ * CallbackAwait.h
+ *
+ *  C++20 coroutine adapter for Callback based async operations.
+ */
+
+#ifndef UTILITY_CALLBACKAWAIT_H_
+#define UTILITY_CALLBACKAWAIT_H_
+
+#include "Callback.h"
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <utility>
+
+/**
+ * Lets a coroutine wait for an async operation that reports completion
+ * through a Callback. Driver code keeps its callback interface:
+ *
+ * void Uart::write(const char* buf, Callback done);
+ *
+ * and adds an awaitable overload on top of it:
+ *
+ * auto Uart::write(const char* buf)
+ * {
+ *     return awaitCallback([this, buf](Callback cb) { write(buf, cb); });
+ * }
+ *
+ * Application code is then written straight line:
+ *
+ * using Frames = CoFramePool<256, 2>;
+ * CoTask<Frames> hello(Uart& uart)
+ * {
+ *     int status = co_await uart.write("Hello ");
+ *     if (status == 0)
+ *         status = co_await uart.write("world\n");
+ * }
+ *
+ * The callback handed to the driver points directly at the resume
+ * function, with the awaiter as data pointer. Completion resumes the
+ * coroutine from inside the callback, e.g. in the ISR, and the int
+ * status becomes the value of the co_await expression. Completion from
+ * inside the start function is also fine, the coroutine then continues
+ * without suspending.
+ *
+ * Coroutine frames come from a CoFramePool, never from the heap.
+ */
+
+/**
+ * Fixed pool of 'frames' coroutine frames of at most 'frameSize' bytes
+ * each. The storage is static, one pool per template instance.
+ * allocate() returns nullptr if the pool is empty or the frame is too
+ * large; the coroutine is then not started. The actual frame size is
+ * known first by the compiler, check that the task starts when sizing
+ * the pool.
+ *
+ * Not thread safe. Start tasks and let them finish at the same priority
+ * level, or guard both.
+ */
+template <std::size_t frameSize, std::size_t frames>
+class CoFramePool
+{
+  public:
+    static void* allocate(std::size_t size) noexcept
+    {
+        if (size > frameSize)
+            return nullptr;
+        Slot* slot = s_free;
+        if (slot)
+            s_free = slot->next;
+        else if (s_used < frames)
+            slot = &s_store[s_used++];
+        else
+            return nullptr;
+        --s_available;
+        return slot->data;
+    }
+
+    static void deallocate(void* ptr) noexcept
+    {
+        Slot* slot = reinterpret_cast<Slot*>(ptr);
+        slot->next = s_free;
+        s_free = slot;
+        ++s_available;
+    }
+
+    static std::size_t available() noexcept
+    {
+        return s_available;
+    }
+
+  private:
+    union alignas(std::max_align_t) Slot
+    {
+        Slot* next;
+        unsigned char data[frameSize];
+    };
+
+    static inline Slot s_store[frames];
+    static inline Slot* s_free = nullptr;
+    static inline std::size_t s_used = 0;
+    static inline std::size_t s_available = frames;
+};
+
+/**
+ * Return type of a fire and forget coroutine with its frame in 'Pool'.
+ * The coroutine starts running at the call and frees its frame when it
+ * returns. Tests false if there was no frame for it, in which case
+ * nothing of the body has run. Report results through a Callback
+ * argument if the caller needs them.
+ */
+template <class Pool>
+class CoTask
+{
+  public:
+    struct promise_type
+    {
+        static void* operator new(std::size_t size) noexcept
+        {
+            return Pool::allocate(size);
+        }
+        static void operator delete(void* ptr) noexcept
+        {
+            Pool::deallocate(ptr);
+        }
+        static CoTask get_return_object_on_allocation_failure() noexcept
+        {
+            return CoTask(false);
+        }
+
+        CoTask get_return_object() noexcept
+        {
+            return CoTask(true);
+        }
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+        std::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept
+        {
+            std::terminate();
+        }
+    };
+
+    // Return true if the coroutine got a frame and was started.
+    explicit operator bool() const
+    {
+        return m_started;
+    }
+
+  private:
+    explicit CoTask(bool started) : m_started(started) {}
+    bool m_started;
+};
+
+/**
+ * Awaiter calling 'start(Callback)' to start the operation. Created by
+ * awaitCallback(), lives in the coroutine frame while waiting.
+ */
+template <class Start>
+class CallbackAwaiter
+{
+  public:
+    explicit CallbackAwaiter(Start start) : m_start(std::move(start)) {}
+    CallbackAwaiter(const CallbackAwaiter&) = delete;
+    CallbackAwaiter& operator=(const CallbackAwaiter&) = delete;
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle) noexcept
+    {
+        m_handle = handle;
+        m_start(Callback::make(&resumeFkn, this));
+        // Whichever of this and the callback comes last continues the
+        // coroutine. Return false to continue it here.
+        return m_state.exchange(suspended) != completed;
+    }
+
+    int await_resume() const noexcept
+    {
+        return m_status;
+    }
+
+  private:
+    enum State : unsigned char
+    {
+        starting,
+        suspended,
+        completed
+    };
+
+    static void resumeFkn(void* obj, int status)
+    {
+        CallbackAwaiter* self = static_cast<CallbackAwaiter*>(obj);
+        self->m_status = status;
+        if (self->m_state.exchange(completed) == suspended)
+            self->m_handle.resume();
+    }
+
+    Start m_start;
+    std::coroutine_handle<> m_handle;
+    int m_status = 0;
+    std::atomic<State> m_state{starting};
+};
+
+/**
+ * Create an awaiter for an operation started by 'start(Callback)'. The
+ * operation must call the callback exactly once.
+ */
+template <class Start>
+CallbackAwaiter<Start>
+awaitCallback(Start start)
+{
+    return CallbackAwaiter<Start>(std::move(start));
+}
+
+#endif /* UTILITY_CALLBACKAWAIT_H_ */
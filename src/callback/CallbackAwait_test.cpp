@@ -0,0 +1,134 @@
+#include "CallbackAwait.h"
+
+#include <cassert>
+#include <string>
+
+namespace
+{
+
+// Driver with a callback interface, completed by calling 'isr'.
+struct Uart
+{
+    void write(const char* buf, Callback done)
+    {
+        out += buf;
+        if (immediate)
+        {
+            done(0);
+            return;
+        }
+        pending = done;
+    }
+
+    // Awaitable overload.
+    auto write(const char* buf)
+    {
+        return awaitCallback([this, buf](Callback cb) { write(buf, cb); });
+    }
+
+    // Transfer done, complete the pending write.
+    void isr(int status)
+    {
+        Callback cb = pending;
+        pending.clear();
+        cb(status);
+    }
+
+    std::string out;
+    Callback pending;
+    bool immediate = false;
+};
+
+using Frames = CoFramePool<256, 2>;
+
+CoTask<Frames>
+hello(Uart& uart, int& result)
+{
+    int status = co_await uart.write("Hello ");
+    if (status == 0)
+        status = co_await uart.write("world");
+    result = status;
+}
+
+} // namespace
+
+void
+testStraightLine()
+{
+    Uart uart;
+    int result = -1;
+    auto task = hello(uart, result);
+    assert(task);
+    assert(Frames::available() == 1);
+
+    // Suspended in the first write.
+    assert(uart.out == "Hello ");
+    assert(uart.pending);
+    uart.isr(0);
+    assert(uart.out == "Hello world");
+    assert(result == -1);
+    uart.isr(7);
+    assert(result == 7);
+
+    // Frame back in the pool.
+    assert(Frames::available() == 2);
+}
+
+void
+testErrorStatus()
+{
+    Uart uart;
+    int result = 0;
+    hello(uart, result);
+    uart.isr(3);
+    assert(uart.out == "Hello ");
+    assert(result == 3);
+    assert(!uart.pending);
+    assert(Frames::available() == 2);
+}
+
+void
+testImmediateCompletion()
+{
+    Uart uart;
+    uart.immediate = true;
+    int result = -1;
+    auto task = hello(uart, result);
+    assert(task);
+    assert(uart.out == "Hello world");
+    assert(result == 0);
+    assert(Frames::available() == 2);
+}
+
+void
+testPoolExhausted()
+{
+    Uart a, b, c;
+    int ra = -1, rb = -1, rc = -1;
+    assert(hello(a, ra));
+    assert(hello(b, rb));
+    // No frame left, the body does not run.
+    auto task = hello(c, rc);
+    assert(!task);
+    assert(c.out.empty());
+
+    a.isr(0);
+    a.isr(0);
+    assert(ra == 0);
+    assert(Frames::available() == 1);
+    assert(hello(c, rc));
+    b.isr(1);
+    c.isr(0);
+    c.isr(0);
+    assert(rb == 1 && rc == 0);
+    assert(Frames::available() == 2);
+}
+
+int
+main()
+{
+    testStraightLine();
+    testErrorStatus();
+    testImmediateCompletion();
+    testPoolExhausted();
+}
@@ -0,0 +1,160 @@
+/*
+ * pipeline.h
+ *
+ *  Statically composed block processing pipelines.
+ */
+
+#ifndef UTILITY_PIPELINE_H_
+#define UTILITY_PIPELINE_H_
+
+#include "delegate.h"
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Fixed chain of processing stages, composed as types. Data is pushed a
+ * block at a time. Each stage gets the block and a sink for its output:
+ *
+ * struct Decimate
+ * {
+ *     template <class Sink>
+ *     void operator()(const int* in, std::size_t n, Sink& sink)
+ *     {
+ *         ... fill 'out' with every other sample ...
+ *         sink(out, n / 2);
+ *     }
+ *     int out[64];
+ * };
+ *
+ * pipeline<Filter, Decimate, Packetize> p;
+ * p.push(samples, 64);
+ *
+ * The sink handed to stage i calls stage i + 1 directly. All calls are
+ * resolved at compile time, so the compiler can inline the whole chain
+ * into push(). A stage may call its sink zero or more times per block,
+ * with any block size, and the output element type may differ from the
+ * input. The sink is only valid during the call.
+ *
+ * Stages that need to change at runtime go in a delegate_stage slot.
+ * That costs one indirect call per block in, and one per block out of
+ * the slot. The rest of the chain stays inlined.
+ *
+ * A pipeline is itself a stage and can be nested in another pipeline.
+ */
+template <class... Stages>
+class pipeline
+{
+  public:
+    pipeline() = default;
+
+    explicit pipeline(Stages... stages) : m_stages(std::move(stages)...) {}
+
+    /**
+     * Process a block. Output of the last stage goes to 'sink', called as
+     * sink(const Out*, std::size_t).
+     */
+    template <class T, class Sink>
+    void push(const T* in, std::size_t n, Sink& sink)
+    {
+        run<0>(in, n, sink);
+    }
+
+    /**
+     * Process a block where the last stage consumes all data itself.
+     */
+    template <class T>
+    void push(const T* in, std::size_t n)
+    {
+        auto discard = [](const auto*, std::size_t) {};
+        run<0>(in, n, discard);
+    }
+
+    // Stage interface, for nesting.
+    template <class T, class Sink>
+    void operator()(const T* in, std::size_t n, Sink& sink)
+    {
+        run<0>(in, n, sink);
+    }
+
+    template <std::size_t i>
+    typename std::tuple_element<i, std::tuple<Stages...>>::type& stage()
+    {
+        return std::get<i>(m_stages);
+    }
+
+  private:
+    template <std::size_t i, class T, class Sink>
+    typename std::enable_if<(i < sizeof...(Stages))>::type
+    run(const T* in, std::size_t n, Sink& sink)
+    {
+        auto next = [this, &sink](const auto* data, std::size_t m) {
+            this->template run<i + 1>(data, m, sink);
+        };
+        std::get<i>(m_stages)(in, n, next);
+    }
+
+    template <std::size_t i, class T, class Sink>
+    typename std::enable_if<(i == sizeof...(Stages))>::type
+    run(const T* in, std::size_t n, Sink& sink)
+    {
+        sink(in, n);
+    }
+
+    std::tuple<Stages...> m_stages;
+};
+
+/**
+ * Create a pipeline from stage objects.
+ */
+template <class... Stages>
+pipeline<Stages...>
+make_pipeline(Stages... stages)
+{
+    return pipeline<Stages...>(std::move(stages)...);
+}
+
+/**
+ * Sink type seen by a stage in a delegate_stage slot.
+ */
+template <class T>
+using block_sink = delegate<void(const T*, std::size_t)>;
+
+/**
+ * Pipeline slot for a stage selected at runtime, taking blocks of In and
+ * producing blocks of Out. The target is a delegate with signature
+ * void(const In*, std::size_t, block_sink<Out>). An empty slot drops
+ * all data.
+ */
+template <class In, class Out>
+class delegate_stage
+{
+  public:
+    using Target = delegate<void(const In*, std::size_t, block_sink<Out>)>;
+
+    delegate_stage() = default;
+    explicit delegate_stage(Target target) : m_target(target) {}
+
+    void set(Target target)
+    {
+        m_target = target;
+    }
+
+    Target get() const
+    {
+        return m_target;
+    }
+
+    template <class Sink>
+    void operator()(const In* in, std::size_t n, Sink& sink)
+    {
+        m_target(in, n, block_sink<Out>::make(sink));
+    }
+
+  private:
+    Target m_target;
+};
+
+#endif /* UTILITY_PIPELINE_H_ */
@@ -0,0 +1,186 @@
+#include "pipeline.h"
+
+#include <cassert>
+#include <vector>
+
+namespace
+{
+
+const std::size_t blockSize = 16;
+
+// Two tap moving sum.
+struct Filter
+{
+    template <class Sink>
+    void operator()(const int* in, std::size_t n, Sink& sink)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            out[i] = in[i] + last;
+            last = in[i];
+        }
+        sink(out, n);
+    }
+    int last = 0;
+    int out[blockSize];
+};
+
+// Keep every 'factor':th sample, across block boundaries.
+template <std::size_t factor>
+struct Decimate
+{
+    template <class Sink>
+    void operator()(const int* in, std::size_t n, Sink& sink)
+    {
+        std::size_t m = 0;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            if (phase == 0)
+                out[m++] = in[i];
+            phase = (phase + 1) % factor;
+        }
+        if (m)
+            sink(out, m);
+    }
+    std::size_t phase = 0;
+    int out[blockSize];
+};
+
+struct Packet
+{
+    int seq;
+    int data[3];
+};
+
+// Collect samples into packets, one sink call per full packet.
+struct Packetize
+{
+    template <class Sink>
+    void operator()(const int* in, std::size_t n, Sink& sink)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            packet.data[fill++] = in[i];
+            if (fill == 3)
+            {
+                sink(&packet, 1);
+                packet.seq++;
+                fill = 0;
+            }
+        }
+    }
+    Packet packet{0, {}};
+    std::size_t fill = 0;
+};
+
+struct Collect
+{
+    void operator()(const Packet* p, std::size_t n)
+    {
+        packets.insert(packets.end(), p, p + n);
+    }
+    std::vector<Packet> packets;
+};
+
+// Runtime selectable stages, same signature.
+void
+passThrough(const int* in, std::size_t n, block_sink<int> sink)
+{
+    sink(in, n);
+}
+
+struct Gain
+{
+    void process(const int* in, std::size_t n, block_sink<int> sink)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            out[i] = in[i] * gain;
+        sink(out, n);
+    }
+    int gain = 10;
+    int out[blockSize];
+};
+
+std::vector<int>
+ramp(int n)
+{
+    std::vector<int> v;
+    for (int i = 1; i <= n; ++i)
+        v.push_back(i);
+    return v;
+}
+
+} // namespace
+
+void
+testStaticPipeline()
+{
+    pipeline<Filter, Decimate<2>, Packetize> p;
+    Collect c;
+    auto in = ramp(24);
+    // Uneven blocks, state carries over.
+    p.push(in.data(), 5, c);
+    p.push(in.data() + 5, 16, c);
+    p.push(in.data() + 21, 3, c);
+
+    // Filter: 1, 3, 5, 7, ... Decimate: 1, 5, 9, 13, ...
+    assert(c.packets.size() == 4);
+    assert(c.packets[0].seq == 0);
+    assert(c.packets[0].data[0] == 1);
+    assert(c.packets[0].data[1] == 5);
+    assert(c.packets[0].data[2] == 9);
+    assert(c.packets[3].seq == 3);
+    assert(c.packets[3].data[2] == 45);
+}
+
+void
+testDelegateSlot()
+{
+    using Slot = delegate_stage<int, int>;
+    pipeline<Filter, Slot, Decimate<2>, Packetize> p;
+    Collect c;
+    auto in = ramp(12);
+
+    // Empty slot drops the data.
+    p.push(in.data(), 6, c);
+    assert(c.packets.empty());
+
+    p.stage<1>().set(Slot::Target::make<passThrough>());
+    p.push(in.data() + 6, 6, c);
+    // Filter continues from 6: 13, 15, 17, 19, 21, 23 -> 13, 17, 21.
+    assert(c.packets.size() == 1);
+    assert(c.packets[0].data[0] == 13);
+    assert(c.packets[0].data[2] == 21);
+
+    Gain g;
+    p.stage<1>().set(Slot::Target::make<Gain, &Gain::process>(g));
+    p.push(in.data(), 6, c);
+    assert(c.packets.size() == 2);
+    assert(c.packets[1].data[0] == 10 * (1 + 12));
+    assert(c.packets[1].data[1] == 10 * 5);
+}
+
+void
+testNested()
+{
+    auto front = make_pipeline(Filter(), Decimate<2>());
+    pipeline<decltype(front), Packetize> p(front, Packetize());
+    Collect c;
+    auto in = ramp(6);
+    p.push(in.data(), 6, c);
+    assert(c.packets.size() == 1);
+    assert(c.packets[0].data[1] == 5);
+
+    // Last stage consuming everything, no sink needed.
+    pipeline<Filter, Decimate<3>> q;
+    q.push(in.data(), 6);
+    assert(q.stage<1>().out[1] == 7);
+}
+
+int
+main()
+{
+    testStaticPipeline();
+    testDelegateSlot();
+    testNested();
+}
@@ -0,0 +1,271 @@
+/*
+ * coalescer.h
+ *
+ *  Adaptive interrupt coalescing for high rate sources.
+ */
+
+#ifndef SRC_ISR_COALESCER_H_
+#define SRC_ISR_COALESCER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * At high event rates the fixed cost of taking an interrupt and running
+ * the handler dominates. The coalescer moves the work out of the ISR and
+ * batches it, in the style of Linux NAPI:
+ *
+ * - The ISR reads the source, post():s the events to a ring and calls
+ *   isr_exit(). That masks the source and schedules the deferred handler.
+ * - The deferred handler calls poll(). It hands the queued events to the
+ *   processing function in blocks, up to a budget. When the ring is
+ *   drained the source is unmasked, otherwise poll is scheduled again.
+ *
+ * While masked, the source holds new events in its own FIFO and keeps
+ * its interrupt pending, so the next ISR picks them all up at once.
+ *
+ * The deferred handler is scheduled with a delay, letting more events
+ * collect first. The delay adapts to the observed event rate: zero when
+ * fewer than two events are expected within 'max_delay', otherwise the
+ * time to collect 'target_batch' events, at most 'max_delay'. Low rates
+ * get low latency, high rates get large batches.
+ *
+ * The platform glue 'Source' provides:
+ * - void mask(), void unmask(): Disable and enable the source interrupt.
+ * - void schedule(uint32_t delay): Run the deferred handler after 'delay'
+ *   ticks, e.g. through a timer or a low priority pended interrupt.
+ * - uint32_t now(): Time in ticks, wrapping.
+ *
+ * post() and isr_exit() are called from the ISR, poll() from the
+ * deferred handler. The two sides only share the ring indexes and the
+ * delay, all atomic, so no cover is needed.
+ */
+
+namespace isr
+{
+
+struct coalesce_config
+{
+    // Longest coalescing delay, in Source ticks.
+    uint32_t max_delay;
+    // Events per poll to aim for at high rates.
+    uint32_t target_batch;
+    // Most events handled per poll() call.
+    uint32_t budget;
+};
+
+struct coalesce_stats
+{
+    std::atomic<uint32_t> irqs{0};
+    std::atomic<uint32_t> overruns{0};
+    std::atomic<uint32_t> polls{0};
+    std::atomic<uint32_t> events{0};
+};
+
+/**
+ * Coalescer for events of type T, queued in a ring of N entries. N must
+ * be a power of two.
+ */
+template <class T, std::size_t N, class Source>
+class coalescer
+{
+    static_assert(N && (N & (N - 1)) == 0, "N must be a power of two");
+
+  public:
+    coalescer(Source& source, const coalesce_config& config)
+        : m_source(source), m_config(config), m_start(source.now())
+    {
+    }
+
+    coalescer(const coalescer&) = delete;
+    coalescer& operator=(const coalescer&) = delete;
+
+    // ISR: Queue an event. Return false and count an overrun if full.
+    bool post(const T& ev)
+    {
+        const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == N)
+        {
+            relaxedAdd(m_stats.overruns);
+            return false;
+        }
+        m_ring[tail & (N - 1)] = ev;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // ISR: Call last in the ISR.
+    void isr_exit()
+    {
+        relaxedAdd(m_stats.irqs);
+        m_source.mask();
+        m_source.schedule(m_delay.load(std::memory_order_relaxed));
+    }
+
+    /**
+     * Deferred handler: Call 'process(const T* block, std::size_t n)' for
+     * queued events, at most 'budget' in total. Return the number of
+     * events processed.
+     */
+    template <class Process>
+    std::size_t poll(Process&& process)
+    {
+        relaxedAdd(m_stats.polls);
+        std::size_t head = m_head.load(std::memory_order_relaxed);
+        const std::size_t tail = m_tail.load(std::memory_order_acquire);
+        std::size_t todo = tail - head;
+        if (todo > m_config.budget)
+            todo = m_config.budget;
+        std::size_t done = 0;
+        while (done < todo)
+        {
+            // Contiguous part, up to the end of the ring.
+            const std::size_t pos = head & (N - 1);
+            std::size_t n = todo - done;
+            if (n > N - pos)
+                n = N - pos;
+            process(static_cast<const T*>(&m_ring[pos]), n);
+            head += n;
+            done += n;
+            m_head.store(head, std::memory_order_release);
+        }
+        relaxedAdd(m_stats.events, uint32_t(done));
+        adapt(done);
+
+        if (head == tail)
+            m_source.unmask();
+        else
+            m_source.schedule(0);
+        return done;
+    }
+
+    // Current coalescing delay in ticks.
+    uint32_t delay() const
+    {
+        return m_delay.load(std::memory_order_relaxed);
+    }
+
+    // Smoothed event rate, in events per 65536 ticks.
+    uint32_t rate() const
+    {
+        return m_rate;
+    }
+
+    const coalesce_stats& stats() const
+    {
+        return m_stats;
+    }
+
+  private:
+    // Single writer counter update, without a read-modify-write.
+    static void relaxedAdd(std::atomic<uint32_t>& a, uint32_t n = 1)
+    {
+        a.store(a.load(std::memory_order_relaxed) + n,
+                std::memory_order_relaxed);
+    }
+
+    // Update the rate estimate and the delay from the events seen since
+    // the previous update.
+    void adapt(std::size_t done)
+    {
+        m_windowEvents += uint32_t(done);
+        const uint32_t now = m_source.now();
+        const uint32_t dt = now - m_start;
+        if (dt == 0)
+            return;
+        const uint64_t sample = (uint64_t(m_windowEvents) << 16) / dt;
+        m_rate = uint32_t(int64_t(m_rate) + (int64_t(sample) - m_rate) / 4);
+        m_start = now;
+        m_windowEvents = 0;
+
+        uint32_t delay = 0;
+        const uint64_t expected =
+            (uint64_t(m_rate) * m_config.max_delay) >> 16;
+        if (expected >= 2)
+        {
+            const uint64_t fill = (uint64_t(m_config.target_batch) << 16) /
+                                  m_rate;
+            delay = fill < m_config.max_delay ? uint32_t(fill)
+                                              : m_config.max_delay;
+        }
+        m_delay.store(delay, std::memory_order_relaxed);
+    }
+
+    Source& m_source;
+    const coalesce_config m_config;
+    coalesce_stats m_stats;
+
+    T m_ring[N];
+    std::atomic<std::size_t> m_head{0};
+    std::atomic<std::size_t> m_tail{0};
+    std::atomic<uint32_t> m_delay{0};
+
+    // Deferred handler only.
+    uint32_t m_start;
+    uint32_t m_windowEvents = 0;
+    uint32_t m_rate = 0;
+};
+} // namespace isr
+
+#if defined(__linux__)
+#include "irq_sim.h"
+
+#include <chrono>
+
+namespace isr
+{
+namespace arch_linux
+{
+
+/**
+ * Source glue for the IRQ simulator. The source interrupt is 'irq', the
+ * deferred handler runs as the lower priority 'deferredIrq', delayed by
+ * the simulator timer. Ticks are microseconds.
+ */
+template <std::size_t irqs>
+class sim_source
+{
+  public:
+    sim_source(irq_sim<irqs>& sim, std::size_t irq, std::size_t deferredIrq)
+        : m_sim(sim), m_irq(irq), m_deferredIrq(deferredIrq)
+    {
+    }
+
+    void mask()
+    {
+        m_sim.disable(m_irq);
+    }
+
+    void unmask()
+    {
+        m_sim.enable(m_irq);
+    }
+
+    void schedule(uint32_t delay)
+    {
+        if (delay)
+            m_sim.raise_after(m_deferredIrq, std::chrono::microseconds(delay));
+        else
+            m_sim.raise(m_deferredIrq);
+    }
+
+    uint32_t now() const
+    {
+        using namespace std::chrono;
+        return uint32_t(
+            duration_cast<microseconds>(steady_clock::now().time_since_epoch())
+                .count());
+    }
+
+  private:
+    irq_sim<irqs>& m_sim;
+    std::size_t m_irq;
+    std::size_t m_deferredIrq;
+};
+} // namespace arch_linux
+} // namespace isr
+
+#endif
+
+#endif /* SRC_ISR_COALESCER_H_ */
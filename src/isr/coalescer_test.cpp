@@ -0,0 +1,237 @@
+/*
+ * coalescer_test.cpp
+ *
+ *  Test of the interrupt coalescer, with a scripted source and on the
+ *  IRQ simulator.
+ */
+#include "coalescer.h"
+
+#include <assert.h>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+
+// Source with a manual clock, recording what the coalescer asks for.
+struct TestSource
+{
+    void mask()
+    {
+        masked = true;
+    }
+    void unmask()
+    {
+        masked = false;
+    }
+    void schedule(uint32_t delay)
+    {
+        scheduled = true;
+        lastDelay = delay;
+    }
+    uint32_t now() const
+    {
+        return time;
+    }
+
+    bool masked = false;
+    bool scheduled = false;
+    uint32_t lastDelay = 0;
+    uint32_t time = 0;
+};
+
+struct Collect
+{
+    void operator()(const int* block, std::size_t n)
+    {
+        blocks++;
+        seen.insert(seen.end(), block, block + n);
+    }
+    int blocks = 0;
+    std::vector<int> seen;
+};
+
+// Deliver 'n' events in one ISR, then poll 'dt' ticks later.
+void
+cycle(isr::coalescer<int, 64, TestSource>& c, TestSource& src, int n,
+      uint32_t dt, Collect& out)
+{
+    for (int i = 0; i < n; ++i)
+        c.post(i);
+    c.isr_exit();
+    src.time += dt;
+    while (src.masked)
+        c.poll(out);
+}
+
+} // namespace
+
+void
+test_batching()
+{
+    TestSource src;
+    isr::coalescer<int, 8, TestSource> c(src, {100, 4, 5});
+    Collect out;
+
+    for (int i = 0; i < 7; ++i)
+        assert(c.post(i));
+    c.isr_exit();
+    assert(src.masked && src.scheduled);
+
+    // Budget of 5, still masked and scheduled again.
+    src.scheduled = false;
+    assert(c.poll(out) == 5);
+    assert(src.masked && src.scheduled);
+    assert(src.lastDelay == 0);
+    assert(c.poll(out) == 2);
+    assert(!src.masked);
+
+    // Wraps, one block per contiguous part.
+    out.blocks = 0;
+    for (int i = 7; i < 13; ++i)
+        assert(c.post(i));
+    c.isr_exit();
+    assert(c.poll(out) == 5);
+    assert(out.blocks == 2);
+    c.poll(out);
+    for (int i = 0; i < 13; ++i)
+        assert(out.seen[i] == i);
+
+    // Overrun.
+    for (int i = 0; i < 9; ++i)
+        c.post(i);
+    assert(c.stats().overruns == 1);
+    assert(c.stats().irqs == 2);
+    assert(c.stats().events == 13);
+}
+
+void
+test_adaptive_delay()
+{
+    TestSource src;
+    isr::coalescer<int, 64, TestSource> c(src, {1000, 32, 64});
+    Collect out;
+
+    // One event per 5000 ticks, too slow to batch. No delay.
+    for (int i = 0; i < 10; ++i)
+        cycle(c, src, 1, 5000, out);
+    assert(c.delay() == 0);
+
+    // 16 events per 100 ticks. Delay to collect 32 is 200 ticks.
+    for (int i = 0; i < 40; ++i)
+        cycle(c, src, 16, 100, out);
+    assert(c.delay() > 180 && c.delay() < 220);
+
+    // 2 events per 100 ticks. Collecting 32 would take 1600 ticks, limited
+    // to 'max_delay'.
+    for (int i = 0; i < 40; ++i)
+        cycle(c, src, 2, 100, out);
+    assert(c.delay() == 1000);
+
+    // Back to slow.
+    for (int i = 0; i < 20; ++i)
+        cycle(c, src, 1, 5000, out);
+    assert(c.delay() == 0);
+}
+
+namespace
+{
+
+enum
+{
+    irqs = 4,
+    deviceIrq = 1,
+    deferredIrq = 3,
+};
+
+using Source = isr::arch_linux::sim_source<irqs>;
+
+// Device with a hardware FIFO, simulated.
+struct Device
+{
+    std::mutex m;
+    std::deque<int> fifo;
+};
+
+Device device;
+isr::coalescer<int, 64, Source>* coal;
+std::atomic<long> sum{0};
+std::atomic<int> received{0};
+
+void
+deviceIsr()
+{
+    std::lock_guard<std::mutex> lk(device.m);
+    while (!device.fifo.empty())
+    {
+        coal->post(device.fifo.front());
+        device.fifo.pop_front();
+    }
+    coal->isr_exit();
+}
+
+void
+deferredIsr()
+{
+    coal->poll([](const int* block, std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i)
+            sum += block[i];
+        received += int(n);
+    });
+}
+
+void
+unusedIsr()
+{
+}
+} // namespace
+
+void
+test_simulated()
+{
+    isr::isr_fkn vectors[irqs] = {unusedIsr, deviceIsr, unusedIsr,
+                                  deferredIsr};
+    isr::arch_linux::irq_sim<irqs> sim(vectors);
+    Source src(sim, deviceIrq, deferredIrq);
+    isr::coalescer<int, 64, Source> c(src, {200, 16, 32});
+    coal = &c;
+
+    const int events = 2000;
+    long sent = 0;
+    int dropped = 0;
+    for (int i = 0; i < events; ++i)
+    {
+        {
+            std::lock_guard<std::mutex> lk(device.m);
+            // Hardware FIFO of 32, the device drops on overflow.
+            if (device.fifo.size() < 32)
+            {
+                device.fifo.push_back(i);
+                sent += i;
+            }
+            else
+                dropped++;
+        }
+        sim.raise(deviceIrq);
+    }
+    // A masked device always has a poll pending or timed, so idle means
+    // drained and unmasked.
+    sim.wait_idle();
+
+    assert(sim.enabled(deviceIrq));
+    assert(c.stats().overruns == 0);
+    assert(received + dropped == events);
+    assert(sum == sent);
+    assert(received == int(c.stats().events));
+    assert(c.stats().irqs <= c.stats().events);
+}
+
+int
+main()
+{
+    test_batching();
+    test_adaptive_delay();
+    test_simulated();
+}
@@ -0,0 +1,206 @@
+/*
+ * irq_sim.h
+ *
+ *  Simulated interrupt controller for running ISR code on Linux.
+ */
+
+#ifndef SRC_ISR_IRQ_SIM_H_
+#define SRC_ISR_IRQ_SIM_H_
+
+#include "isr.h"
+
+#include <array>
+#include <bitset>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+
+namespace isr
+{
+namespace arch_linux
+{
+
+/**
+ * Interrupt controller simulated by a thread acting as the CPU in handler
+ * mode. raise() sets an IRQ pending from any thread. Pending and enabled
+ * IRQs run one at a time, lowest number first, each to completion,
+ * through its entry in 'vectors'. Like an NVIC, an IRQ raised while
+ * disabled stays pending until enabled again. All IRQs start enabled.
+ * raise_after() plays a one shot timer per IRQ.
+ *
+ * With a cover set, every handler runs inside a sync_lock of it, so a
+ * protect_lock in thread code keeps the ISRs out like disabling
+ * interrupts would.
+ */
+template <std::size_t irqs>
+class irq_sim
+{
+  public:
+    explicit irq_sim(const isr_fkn* vectors,
+                     cover<SystemCover>* irqCover = nullptr)
+        : m_vectors(vectors), m_cover(irqCover)
+    {
+        m_enabled.set();
+        m_thread = std::thread([this] { loop(); });
+    }
+
+    irq_sim(const irq_sim&) = delete;
+    irq_sim& operator=(const irq_sim&) = delete;
+
+    ~irq_sim()
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        m_thread.join();
+    }
+
+    void raise(std::size_t irq)
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_pending.set(irq);
+        }
+        m_cv.notify_all();
+    }
+
+    // Raise 'irq' when 'delay' has passed. Replaces an earlier request.
+    void raise_after(std::size_t irq, std::chrono::microseconds delay)
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_due[irq] = clock::now() + delay;
+            m_timed.set(irq);
+        }
+        m_cv.notify_all();
+    }
+
+    void enable(std::size_t irq)
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_enabled.set(irq);
+        }
+        m_cv.notify_all();
+    }
+
+    void disable(std::size_t irq)
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        m_enabled.reset(irq);
+    }
+
+    bool enabled(std::size_t irq)
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        return m_enabled.test(irq);
+    }
+
+    // Wait until no enabled IRQ is pending, timed or running.
+    void wait_idle()
+    {
+        std::unique_lock<std::mutex> lk(m_mutex);
+        m_cv.wait(lk,
+                  [this] { return !m_busy && !runnable() && m_timed.none(); });
+    }
+
+    // Number of handlers run.
+    unsigned long handled()
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        return m_handled;
+    }
+
+  private:
+    using clock = std::chrono::steady_clock;
+
+    bool runnable() const
+    {
+        return (m_pending & m_enabled).any();
+    }
+
+    void loop()
+    {
+        std::unique_lock<std::mutex> lk(m_mutex);
+        for (;;)
+        {
+            if (m_stop)
+                return;
+            expire();
+            if (!runnable())
+            {
+                if (m_timed.any())
+                    m_cv.wait_until(lk, nextDue());
+                else
+                    m_cv.wait(lk);
+                continue;
+            }
+            std::size_t irq = 0;
+            while (!(m_pending.test(irq) && m_enabled.test(irq)))
+                ++irq;
+            m_pending.reset(irq);
+            m_busy = true;
+            lk.unlock();
+            run(irq);
+            lk.lock();
+            m_busy = false;
+            ++m_handled;
+            m_cv.notify_all();
+        }
+    }
+
+    clock::time_point nextDue() const
+    {
+        clock::time_point due = clock::time_point::max();
+        for (std::size_t i = 0; i < irqs; ++i)
+            if (m_timed.test(i) && m_due[i] < due)
+                due = m_due[i];
+        return due;
+    }
+
+    // Move timed IRQs that are due to pending.
+    void expire()
+    {
+        if (m_timed.none())
+            return;
+        const clock::time_point now = clock::now();
+        for (std::size_t i = 0; i < irqs; ++i)
+            if (m_timed.test(i) && m_due[i] <= now)
+            {
+                m_timed.reset(i);
+                m_pending.set(i);
+            }
+    }
+
+    void run(std::size_t irq)
+    {
+        if (!m_cover)
+        {
+            m_vectors[irq]();
+            return;
+        }
+        auto lk = make_synclock(*m_cover);
+        m_vectors[irq]();
+    }
+
+    const isr_fkn* m_vectors;
+    cover<SystemCover>* m_cover;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::bitset<irqs> m_pending;
+    std::bitset<irqs> m_enabled;
+    std::bitset<irqs> m_timed;
+    std::array<clock::time_point, irqs> m_due;
+    bool m_busy = false;
+    bool m_stop = false;
+    unsigned long m_handled = 0;
+    std::thread m_thread;
+};
+} // namespace arch_linux
+} // namespace isr
+
+#endif /* SRC_ISR_IRQ_SIM_H_ */
@@ -56,6 +56,9 @@
 namespace isr
 {
 
+// Interrupt handler, as stored in a vector table.
+using isr_fkn = void (*)();
+
 /**
  * An analog to a mutex but for high/low priority tasks/interrupts
  * which possibly share a stack. The low level task creates a critical
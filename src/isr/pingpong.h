@@ -0,0 +1,205 @@
+/*
+ * pingpong.h
+ *
+ *  DMA buffer ownership between an ISR and a thread, without covers.
+ */
+
+#ifndef SRC_ISR_PINGPONG_H_
+#define SRC_ISR_PINGPONG_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace isr
+{
+
+/**
+ * View of one buffer.
+ */
+template <typename T>
+struct span
+{
+    T* data = nullptr;
+    std::size_t size = 0;
+
+    T* begin() const
+    {
+        return data;
+    }
+    T* end() const
+    {
+        return data + size;
+    }
+    T& operator[](std::size_t i) const
+    {
+        return data[i];
+    }
+    explicit operator bool() const
+    {
+        return data != nullptr;
+    }
+};
+
+/**
+ * N buffers of T cycling between DMA/ISR ownership and thread ownership,
+ * for streaming e.g. audio or ADC samples.
+ *
+ * ISR side:
+ * - isr_claim(): Take a free buffer to program as DMA target. Call once
+ *   at start, twice for double buffered DMA.
+ * - isr_complete(): The oldest DMA buffer is full. Hands it to the
+ *   thread and returns the next buffer to program.
+ * Thread side:
+ * - acquire(): Oldest full buffer, in completion order, or an empty span.
+ * - release(span): Done with the buffer, it becomes free.
+ *
+ * If isr_complete() finds no free buffer, the thread is too slow. The
+ * completed buffer is then not handed over but reused as the next DMA
+ * target, and an overrun is counted. The data lost is the newest, the
+ * thread still gets all older buffers in order.
+ *
+ * Each buffer has an atomic ownership state, and every state change is
+ * made by the side currently owning the buffer. Both sides therefore
+ * only need atomic loads and stores, no read-modify-write and no cover.
+ * That works on Cortex M0 as well, and thread code holding a
+ * protect_lock does not delay the ISR. One thread and one ISR level.
+ *
+ * The storage, N * len elements, is given by the user so it can be
+ * placed in DMA capable memory. With a data cache, invalidate a buffer
+ * after acquire() before reading it.
+ */
+template <typename T, std::size_t N>
+class pingpong
+{
+    static_assert(N >= 2 && N <= 255, "2 to 255 buffers");
+
+    enum State : uint8_t
+    {
+        idle,
+        dma,
+        full,
+        held
+    };
+
+  public:
+    pingpong(T* storage, std::size_t len) : m_storage(storage), m_len(len)
+    {
+        for (auto& s : m_state)
+            s.store(idle, std::memory_order_relaxed);
+    }
+
+    pingpong(const pingpong&) = delete;
+    pingpong& operator=(const pingpong&) = delete;
+
+    // ISR: Claim a free buffer as DMA target. Empty span if none is free.
+    span<T> isr_claim()
+    {
+        for (std::size_t n = 0; n < N; ++n)
+        {
+            const std::size_t i = (m_claimNext + n) % N;
+            if (m_state[i].load(std::memory_order_acquire) == idle)
+            {
+                m_claimNext = (i + 1) % N;
+                m_state[i].store(dma, std::memory_order_relaxed);
+                pushDma(i);
+                return buffer(i);
+            }
+        }
+        return span<T>();
+    }
+
+    /**
+     * ISR: The oldest DMA buffer is complete. Return the buffer to program
+     * as the following DMA target.
+     */
+    span<T> isr_complete()
+    {
+        const std::size_t done = popDma();
+        span<T> next = isr_claim();
+        if (!next)
+        {
+            // Thread behind. Drop the new data, refill the same buffer.
+            m_overruns.store(m_overruns.load(std::memory_order_relaxed) + 1,
+                             std::memory_order_relaxed);
+            pushDma(done);
+            return buffer(done);
+        }
+        m_seq[done] = m_fullSeq++;
+        m_state[done].store(full, std::memory_order_release);
+        return next;
+    }
+
+    // Thread: Take the oldest full buffer. Empty span if none.
+    span<T> acquire()
+    {
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            if (m_state[i].load(std::memory_order_acquire) == full &&
+                m_seq[i] == m_acquireSeq)
+            {
+                m_acquireSeq++;
+                m_state[i].store(held, std::memory_order_relaxed);
+                return buffer(i);
+            }
+        }
+        return span<T>();
+    }
+
+    // Thread: Give back a buffer from acquire().
+    void release(span<T> buf)
+    {
+        const std::size_t i = std::size_t(buf.data - m_storage) / m_len;
+        m_state[i].store(idle, std::memory_order_release);
+    }
+
+    // Buffers dropped since start.
+    uint32_t overruns() const
+    {
+        return m_overruns.load(std::memory_order_relaxed);
+    }
+
+  private:
+    span<T> buffer(std::size_t i) const
+    {
+        span<T> s;
+        s.data = m_storage + i * m_len;
+        s.size = m_len;
+        return s;
+    }
+
+    // DMA targets in programming order, ISR only.
+    void pushDma(std::size_t i)
+    {
+        m_dmaQueue[(m_dmaHead + m_dmaCount++) % N] = uint8_t(i);
+    }
+
+    std::size_t popDma()
+    {
+        const std::size_t i = m_dmaQueue[m_dmaHead];
+        m_dmaHead = (m_dmaHead + 1) % N;
+        m_dmaCount--;
+        return i;
+    }
+
+    T* const m_storage;
+    const std::size_t m_len;
+    std::atomic<uint8_t> m_state[N];
+    // Completion order of full buffers, written by the ISR before the
+    // buffer is published as full.
+    uint32_t m_seq[N] = {};
+    std::atomic<uint32_t> m_overruns{0};
+
+    // ISR only.
+    uint8_t m_dmaQueue[N] = {};
+    std::size_t m_dmaHead = 0;
+    std::size_t m_dmaCount = 0;
+    std::size_t m_claimNext = 0;
+    uint32_t m_fullSeq = 0;
+
+    // Thread only.
+    uint32_t m_acquireSeq = 0;
+};
+} // namespace isr
+
+#endif /* SRC_ISR_PINGPONG_H_ */
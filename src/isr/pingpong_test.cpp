@@ -0,0 +1,135 @@
+/*
+ * pingpong_test.cpp
+ *
+ *  Test of the DMA buffer ownership manager.
+ */
+#include "pingpong.h"
+
+#include <assert.h>
+#include <atomic>
+#include <thread>
+
+namespace
+{
+
+enum
+{
+    len = 4,
+};
+
+// Play the DMA: fill the buffer with consecutive sample numbers.
+void
+fill(isr::span<int> buf, int& sample)
+{
+    for (int& v : buf)
+        v = sample++;
+}
+} // namespace
+
+void
+test_cycle()
+{
+    int storage[3 * len];
+    isr::pingpong<int, 3> pp(storage, len);
+    int sample = 0;
+
+    // Double buffered DMA.
+    isr::span<int> a = pp.isr_claim();
+    isr::span<int> b = pp.isr_claim();
+    assert(a && b && a.data != b.data);
+    assert(!pp.acquire());
+
+    fill(a, sample);
+    isr::span<int> c = pp.isr_complete();
+    assert(c && c.data != a.data && c.data != b.data);
+
+    isr::span<int> got = pp.acquire();
+    assert(got.data == a.data);
+    assert(got[0] == 0 && got[3] == 3);
+    assert(!pp.acquire());
+
+    // Thread holds 'a', DMA has 'b' and 'c'. Completing 'b' finds no free
+    // buffer, 'b' is dropped and refilled.
+    fill(b, sample);
+    isr::span<int> next = pp.isr_complete();
+    assert(next.data == b.data);
+    assert(pp.overruns() == 1);
+    assert(!pp.acquire());
+
+    // DMA fills 'c', then 'b' again, in that order.
+    pp.release(got);
+    fill(c, sample);
+    next = pp.isr_complete();
+    assert(next.data == a.data);
+    got = pp.acquire();
+    assert(got.data == c.data && got[0] == 8);
+    pp.release(got);
+
+    fill(b, sample);
+    next = pp.isr_complete();
+    assert(next.data == c.data);
+    got = pp.acquire();
+    assert(got.data == b.data && got[0] == 12);
+    pp.release(got);
+    assert(!pp.acquire());
+    assert(pp.overruns() == 1);
+}
+
+void
+test_threaded()
+{
+    enum
+    {
+        buffers = 4,
+        blocks = 20000,
+    };
+    static int storage[buffers * len];
+    isr::pingpong<int, buffers> pp(storage, len);
+    std::atomic<bool> done{false};
+
+    // ISR side, no locks.
+    std::thread isrThread([&] {
+        int sample = 0;
+        isr::span<int> cur = pp.isr_claim();
+        for (int i = 0; i < blocks; ++i)
+        {
+            fill(cur, sample);
+            cur = pp.isr_complete();
+            if (i % 64 == 0)
+                std::this_thread::yield();
+        }
+        done = true;
+    });
+
+    // Samples must increase, in whole blocks, with gaps only for overruns.
+    int received = 0;
+    int last = -1;
+    for (;;)
+    {
+        // Read before acquire, nothing can complete after 'done'.
+        const bool finished = done;
+        isr::span<int> buf = pp.acquire();
+        if (!buf)
+        {
+            if (finished)
+                break;
+            std::this_thread::yield();
+            continue;
+        }
+        assert(buf[0] > last && buf[0] % len == 0);
+        for (int i = 1; i < len; ++i)
+            assert(buf[i] == buf[0] + i);
+        last = buf[len - 1];
+        received++;
+        pp.release(buf);
+    }
+    isrThread.join();
+    assert(received + int(pp.overruns()) == blocks);
+}
+
+int
+main()
+{
+    test_cycle();
+    test_threaded();
+}
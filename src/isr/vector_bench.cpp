@@ -0,0 +1,105 @@
+/*
+ * vector_bench.cpp
+ *
+ *  Per interrupt dispatch cost of the delegate vector table compared to
+ *  a static vector entry. Run with 'make bench'.
+ *
+ *  Each variant calls the handler through a function pointer loaded from
+ *  a vector table, as the CPU does on exception entry:
+ *  - static:     Entry is a free function calling the driver directly.
+ *  - trampoline: Entry is vector_table::entry<n>, calling the delegate.
+ *  - dispatch:   Software dispatch by IRQ number, vector_table::dispatch.
+ *  The same driver ISR body runs in all variants. The simulated controller
+ *  is also measured, raise to handled, to show what the Linux simulation
+ *  adds on top.
+ */
+#include "irq_sim.h"
+#include "vector_table.h"
+
+#include "../timing/cycle_clock.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+
+struct UsartDriver
+{
+    __attribute__((noinline)) void isr()
+    {
+        // Read status, write data register.
+        data = status + 1;
+    }
+    volatile int status = 0;
+    volatile int data = 0;
+};
+
+enum
+{
+    irqs = 32,
+    usartIrq = 17,
+};
+
+using Vectors = isr::vector_table<irqs>;
+
+UsartDriver usart;
+
+void
+usartStaticIrq()
+{
+    usart.isr();
+}
+
+// Vector table as seen by the CPU, in memory it cannot see through.
+isr::isr_fkn volatile staticVectors[irqs];
+isr::isr_fkn volatile delegateVectors[irqs];
+
+template <class Call>
+double
+nsPerCall(long n, Call call)
+{
+    using timing::cycle_clock;
+    const cycle_clock::rep t0 = cycle_clock::now();
+    for (long i = 0; i < n; ++i)
+        call();
+    const cycle_clock::rep t = cycle_clock::now() - t0;
+    return double(t) * 1e9 / double(cycle_clock::frequency()) / n;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+    const long scale = argc > 1 ? std::atol(argv[1]) : 1;
+    const long n = scale * 20000000;
+
+    Vectors::attach(usartIrq,
+                    delegate<void()>::make<UsartDriver, &UsartDriver::isr>(
+                        usart));
+    staticVectors[usartIrq] = &usartStaticIrq;
+    delegateVectors[usartIrq] = Vectors::entry(usartIrq);
+
+    volatile int irq = usartIrq;
+    const double stat = nsPerCall(n, [&] { staticVectors[irq](); });
+    const double tramp = nsPerCall(n, [&] { delegateVectors[irq](); });
+    const double disp = nsPerCall(n, [&] { Vectors::dispatch(irq); });
+
+    std::printf("Dispatch cost, ns per interrupt\n");
+    std::printf("%-12s %8.2f\n", "static", stat);
+    std::printf("%-12s %8.2f  (+%.2f)\n", "trampoline", tramp, tramp - stat);
+    std::printf("%-12s %8.2f  (+%.2f)\n", "dispatch", disp, disp - stat);
+
+    isr::isr_fkn vectors[irqs];
+    Vectors::fill(vectors);
+    isr::arch_linux::irq_sim<irqs> sim(vectors);
+    const long raised = scale * 20000;
+    const double simNs = nsPerCall(raised, [&] {
+        sim.raise(usartIrq);
+        sim.wait_idle();
+    });
+    std::printf("%-12s %8.0f  (Linux simulation, raise to handled)\n",
+                "irq_sim", simNs);
+    return 0;
+}
@@ -0,0 +1,165 @@
+/*
+ * vector_table.h
+ *
+ *  Interrupt vector table of delegates.
+ */
+
+#ifndef SRC_ISR_VECTOR_TABLE_H_
+#define SRC_ISR_VECTOR_TABLE_H_
+
+#include "../callback/delegate.h"
+#include "isr.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+/**
+ * Lets drivers register ISR handlers at runtime as delegate<void()>, so one
+ * driver class can serve several peripherals:
+ *
+ * UsartDriver usart1, usart2;
+ * using Vectors = isr::vector_table<32>;
+ * Vectors::attach(USART1_IRQn, delegate<void()>::make<UsartDriver,
+ *                                 &UsartDriver::isr>(usart1));
+ *
+ * Each IRQ gets a first level trampoline, 'Vectors::entry<n>', a plain C++
+ * function calling the delegate in slot n. Put the trampolines in the
+ * hardware vector table, either in flash at link time or, on Cortex
+ * M3-7, in a RAM table with arch_armv7_m::ram_vectors below. Dispatch
+ * then costs the trampoline plus the delegate call, compared to a static
+ * vector entry pointing at the handler directly.
+ *
+ * Slots are plain memory, two pointers each. Attach and detach while the
+ * IRQ is disabled, so the ISR never sees a half written slot. An empty
+ * slot is a no-op.
+ *
+ * The slots are static, one set per template instance. Use 'Tag' for
+ * separate tables.
+ */
+
+namespace isr
+{
+
+template <std::size_t irqs, class Tag = void>
+class vector_table
+{
+  public:
+    using handler_type = delegate<void()>;
+
+    static void attach(std::size_t irq, handler_type handler)
+    {
+        s_slots[irq] = handler;
+    }
+
+    static void detach(std::size_t irq)
+    {
+        s_slots[irq].clear();
+    }
+
+    static handler_type handler(std::size_t irq)
+    {
+        return s_slots[irq];
+    }
+
+    // First level handler for IRQ n, for use as a vector entry.
+    template <std::size_t n>
+    static void entry()
+    {
+        static_assert(n < irqs, "IRQ number out of range");
+        s_slots[n]();
+    }
+
+    // Address of the trampoline for 'irq', selected at runtime.
+    static isr_fkn entry(std::size_t irq)
+    {
+        return entries(std::make_index_sequence<irqs>())[irq];
+    }
+
+    // Write all trampolines to 'vectors', e.g. the IRQ part of a RAM table.
+    static void fill(isr_fkn* vectors)
+    {
+        const isr_fkn* e = entries(std::make_index_sequence<irqs>());
+        for (std::size_t i = 0; i < irqs; ++i)
+            vectors[i] = e[i];
+    }
+
+    // Call the handler for 'irq'. For simulators and software dispatch.
+    static void dispatch(std::size_t irq)
+    {
+        s_slots[irq]();
+    }
+
+  private:
+    template <std::size_t... n>
+    static const isr_fkn* entries(std::index_sequence<n...>)
+    {
+        static const isr_fkn table[] = {&entry<n>...};
+        return table;
+    }
+
+    static handler_type s_slots[irqs];
+};
+
+template <std::size_t irqs, class Tag>
+delegate<void()> vector_table<irqs, Tag>::s_slots[irqs];
+} // namespace isr
+
+// Cortex M3-7, relocatable vector table.
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+
+namespace isr
+{
+namespace arch_armv7_m
+{
+
+// VTOR requires alignment to the table size rounded up to a power of two,
+// at least 128 bytes.
+constexpr std::size_t
+vector_alignment(std::size_t bytes)
+{
+    std::size_t a = 128;
+    while (a < bytes)
+        a *= 2;
+    return a;
+}
+
+/**
+ * Vector table in RAM. The 16 core exception entries are copied from the
+ * active table, the IRQ entries are the trampolines of
+ * vector_table<irqs, Tag>. Instantiate as a static object.
+ */
+template <std::size_t irqs, class Tag = void>
+class ram_vectors
+{
+    enum
+    {
+        coreVectors = 16,
+        entries = coreVectors + irqs,
+        alignment = vector_alignment(entries * sizeof(isr_fkn)),
+    };
+
+  public:
+    // Switch to this table. Call with interrupts disabled.
+    void install()
+    {
+        volatile uint32_t* const vtor =
+            reinterpret_cast<volatile uint32_t*>(0xe000ed08);
+        const isr_fkn* active = reinterpret_cast<const isr_fkn*>(*vtor);
+        for (std::size_t i = 0; i < coreVectors; ++i)
+            m_vectors[i] = active[i];
+        vector_table<irqs, Tag>::fill(m_vectors + coreVectors);
+        __asm__ __volatile__(" dsb\n" : : : "memory");
+        *vtor = uint32_t(reinterpret_cast<uintptr_t>(m_vectors));
+        __asm__ __volatile__(" dsb\n isb\n" : : : "memory");
+    }
+
+  private:
+    alignas(alignment) isr_fkn m_vectors[entries];
+};
+} // namespace arch_armv7_m
+} // namespace isr
+
+#endif
+
+#endif /* SRC_ISR_VECTOR_TABLE_H_ */
@@ -0,0 +1,382 @@
+/*
+ * ActiveObject.h
+ *
+ *  FSM bound to an inbound queue and an execution context.
+ */
+
+#ifndef SRC_STATECHART_ACTIVEOBJECT_H_
+#define SRC_STATECHART_ACTIVEOBJECT_H_
+
+#include "MpscQueue.h"
+#include "StateChart.h"
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+#ifndef STATECHART_FREESTANDING
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#endif
+
+/**
+ * An active object owns an FSM, a lock free inbound queue and an
+ * execution context. Any thread may post events, through the object or a
+ * copyable active_handle. The FSM only runs in the context, one run at a
+ * time, so FSM and state code needs no locking.
+ *
+ * active_object<Service> ao;
+ * ao.start(Service::StateId::idle);
+ * active_handle<Service::Event> h = ao.handle();
+ * h.post(ev); // From any thread.
+ *
+ * Contexts:
+ * - ThreadContext: A dedicated thread, sleeping when idle.
+ * - ExecutorContext<Executor>: Runs are submitted to an executor, e.g.
+ *   ThreadPool. Runs of one object never overlap, runs of different
+ *   objects may execute in parallel.
+ * - DeferredContext: Calls a pend function, e.g. setting a low priority
+ *   interrupt pending. The handler of that interrupt calls runPending().
+ *
+ * A context has 'bind(ActiveRun)', called once with the run function, and
+ * 'schedule()', called when the object goes from idle to having events.
+ */
+
+/**
+ * Type erased 'run the object' call handed to contexts.
+ */
+struct ActiveRun
+{
+    void (*fkn)(void* obj);
+    void* obj;
+
+    void operator()() const
+    {
+        fkn(obj);
+    }
+};
+
+/**
+ * Lightweight copyable reference used to post events to an active object.
+ */
+template <class Event>
+class active_handle
+{
+  public:
+    active_handle() = default;
+    active_handle(void* obj, bool (*post)(void*, const Event&))
+        : m_obj(obj), m_post(post)
+    {
+    }
+
+    // Return false if the inbound queue is full and the event is dropped.
+    bool post(const Event& ev) const
+    {
+        return m_post(m_obj, ev);
+    }
+
+    explicit operator bool() const
+    {
+        return m_obj != nullptr;
+    }
+
+  private:
+    void* m_obj = nullptr;
+    bool (*m_post)(void*, const Event&) = nullptr;
+};
+
+/**
+ * Context for running an object from a deferred work level, typically an
+ * interrupt with the lowest priority. 'pend' is called on the posting
+ * thread or interrupt, and should only make the handler pending.
+ */
+class DeferredContext
+{
+  public:
+    explicit DeferredContext(void (*pend)(void* arg), void* arg = nullptr)
+        : m_pend(pend), m_arg(arg)
+    {
+    }
+
+    void bind(ActiveRun run)
+    {
+        m_run = run;
+    }
+
+    void schedule()
+    {
+        m_pend(m_arg);
+    }
+
+    // Call from the deferred handler.
+    void runPending()
+    {
+        m_run();
+    }
+
+  private:
+    void (*m_pend)(void* arg);
+    void* m_arg;
+    ActiveRun m_run{};
+};
+
+#ifndef STATECHART_FREESTANDING
+/**
+ * Context with a thread of its own.
+ */
+class ThreadContext
+{
+  public:
+    ThreadContext() = default;
+    ThreadContext(const ThreadContext&) = delete;
+    ThreadContext& operator=(const ThreadContext&) = delete;
+
+    ~ThreadContext()
+    {
+        if (!m_thread.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_one();
+        m_thread.join();
+    }
+
+    void bind(ActiveRun run)
+    {
+        m_thread = std::thread([this, run] { loop(run); });
+    }
+
+    void schedule()
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_pending = true;
+        }
+        m_cv.notify_one();
+    }
+
+  private:
+    void loop(ActiveRun run)
+    {
+        std::unique_lock<std::mutex> lk(m_mutex);
+        for (;;)
+        {
+            m_cv.wait(lk, [this] { return m_pending || m_stop; });
+            if (m_stop)
+                return;
+            m_pending = false;
+            lk.unlock();
+            run();
+            lk.lock();
+        }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_pending = false;
+    bool m_stop = false;
+    std::thread m_thread;
+};
+
+/**
+ * Fixed set of worker threads executing ActiveRun:s in FIFO order.
+ */
+class ThreadPool
+{
+  public:
+    explicit ThreadPool(int threads)
+    {
+        for (int i = 0; i < threads; ++i)
+            m_threads.emplace_back([this] { loop(); });
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Finish queued work, then stop.
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        for (auto& t : m_threads)
+            t.join();
+    }
+
+    void execute(ActiveRun run)
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_work.push_back(run);
+        }
+        m_cv.notify_one();
+    }
+
+  private:
+    void loop()
+    {
+        std::unique_lock<std::mutex> lk(m_mutex);
+        for (;;)
+        {
+            m_cv.wait(lk, [this] { return !m_work.empty() || m_stop; });
+            if (m_work.empty())
+                return;
+            ActiveRun run = m_work.front();
+            m_work.pop_front();
+            lk.unlock();
+            run();
+            lk.lock();
+        }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<ActiveRun> m_work;
+    bool m_stop = false;
+    std::vector<std::thread> m_threads;
+};
+#endif
+
+/**
+ * Context submitting runs to an executor with 'execute(ActiveRun)'. The
+ * executor must outlive the object and have no runs of it left when the
+ * object is destroyed.
+ */
+template <class Executor>
+class ExecutorContext
+{
+  public:
+    explicit ExecutorContext(Executor& executor) : m_executor(executor) {}
+
+    void bind(ActiveRun run)
+    {
+        m_run = run;
+    }
+
+    void schedule()
+    {
+        m_executor.execute(m_run);
+    }
+
+  private:
+    Executor& m_executor;
+    ActiveRun m_run{};
+};
+
+#ifdef STATECHART_FREESTANDING
+template <class Fsm, class Queue = MpscQueue<typename Fsm::Event, 16>,
+          class Context = DeferredContext>
+#else
+template <class Fsm, class Queue = MpscQueue<typename Fsm::Event, 64>,
+          class Context = ThreadContext>
+#endif
+class active_object
+{
+  public:
+    using Event = typename Fsm::Event;
+    using StateId = typename Fsm::StateId;
+
+    /**
+     * Arguments are passed on to the Context constructor.
+     */
+    template <class... Args>
+    explicit active_object(Args&&... args)
+        : m_context(std::forward<Args>(args)...)
+    {
+        m_context.bind(ActiveRun{&runFkn, this});
+    }
+
+    active_object(const active_object&) = delete;
+    active_object& operator=(const active_object&) = delete;
+
+    /**
+     * Start the FSM. Call before events are posted.
+     */
+    void start(StateId id)
+    {
+        m_fsm.setStartState(id);
+    }
+
+    /**
+     * Queue an event for the FSM, from any thread. Return false if the
+     * inbound queue is full and the event is dropped.
+     */
+    bool post(const Event& ev)
+    {
+        if (!m_queue.push(ev))
+            return false;
+        // Whoever moves 'scheduled' from false to true schedules one run.
+        if (!m_scheduled.exchange(true))
+            m_context.schedule();
+        return true;
+    }
+
+    active_handle<Event> handle()
+    {
+        return active_handle<Event>(this, &postFkn);
+    }
+
+    /**
+     * The FSM. Only to be used from the context, or while no events are
+     * being posted.
+     */
+    Fsm& fsm()
+    {
+        return m_fsm;
+    }
+
+    Context& context()
+    {
+        return m_context;
+    }
+
+    /**
+     * Deliver all queued events to the FSM. Called by the context.
+     */
+    void run()
+    {
+        for (;;)
+        {
+            while (!m_queue.empty())
+            {
+                Event ev = m_queue.front();
+                m_queue.pop();
+                m_fsm.postEvent(ev);
+            }
+            m_scheduled.store(false);
+            // An event pushed before the store above may have skipped
+            // scheduling. Take the run back if so, unless a new run is
+            // already scheduled.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_queue.empty() || m_scheduled.exchange(true))
+                return;
+        }
+    }
+
+  private:
+    static void runFkn(void* obj)
+    {
+        static_cast<active_object*>(obj)->run();
+    }
+
+    static bool postFkn(void* obj, const Event& ev)
+    {
+        return static_cast<active_object*>(obj)->post(ev);
+    }
+
+    Fsm m_fsm;
+    Queue m_queue;
+    std::atomic<bool> m_scheduled{false};
+
+    // Last, so a context thread is stopped before the FSM is destroyed.
+    Context m_context;
+};
+
+#endif /* SRC_STATECHART_ACTIVEOBJECT_H_ */
@@ -0,0 +1,99 @@
+/*
+ * FixedQueue.h
+ *
+ *  Fixed capacity event queue for the statechart.
+ */
+
+#ifndef SRC_UTILITY_FIXEDQUEUE_H_
+#define SRC_UTILITY_FIXEDQUEUE_H_
+
+#include <cstddef>
+#include <new>
+
+/**
+ * Ring buffer queue with room for 'capacity' elements stored inline.
+ * No heap allocation and no requirement on El being default constructible.
+ * Same interface as VecQueue. Pushing to a full queue is a precondition
+ * violation, check 'full()' first.
+ */
+template <class El, std::size_t capacity>
+class FixedQueue
+{
+  public:
+    static_assert(capacity > 0, "");
+
+    FixedQueue() = default;
+    FixedQueue(const FixedQueue&) = delete;
+    FixedQueue& operator=(const FixedQueue&) = delete;
+
+    ~FixedQueue()
+    {
+        clear();
+    }
+
+    void push(const El& el)
+    {
+        std::size_t pos = m_head + m_size;
+        if (pos >= capacity)
+            pos -= capacity;
+        new (slot(pos)) El(el);
+        ++m_size;
+    }
+
+    void pop()
+    {
+        front().~El();
+        if (++m_head == capacity)
+            m_head = 0;
+        --m_size;
+    }
+
+    El& front()
+    {
+        return *slot(m_head);
+    }
+    const El& front() const
+    {
+        return *slot(m_head);
+    }
+
+    std::size_t size() const
+    {
+        return m_size;
+    }
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+    bool full() const
+    {
+        return m_size == capacity;
+    }
+
+    void clear()
+    {
+        while (!empty())
+            pop();
+    }
+
+  private:
+    El* slot(std::size_t i)
+    {
+        return reinterpret_cast<El*>(&m_store[i]);
+    }
+    const El* slot(std::size_t i) const
+    {
+        return reinterpret_cast<const El*>(&m_store[i]);
+    }
+
+    struct alignas(El) Slot
+    {
+        unsigned char data[sizeof(El)];
+    };
+
+    Slot m_store[capacity];
+    std::size_t m_head = 0;
+    std::size_t m_size = 0;
+};
+
+#endif /* SRC_UTILITY_FIXEDQUEUE_H_ */
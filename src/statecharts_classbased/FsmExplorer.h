@@ -0,0 +1,251 @@
+/*
+ * FsmExplorer.h
+ *
+ *  Measure worst case run to completion times of an FSM.
+ */
+
+#ifndef SRC_STATECHART_FSMEXPLORER_H_
+#define SRC_STATECHART_FSMEXPLORER_H_
+
+#include "FsmMonitor.h"
+#include "StateChart.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <random>
+#include <vector>
+
+/**
+ * Number of heap allocations so far. Only counted when
+ * fsm_alloc_hook.cpp, which replaces the global operator new, is linked
+ * into the program. Otherwise it stays 0.
+ */
+inline std::atomic<long>&
+fsmAllocCounter()
+{
+    static std::atomic<long> count{0};
+    return count;
+}
+
+/**
+ * Test harness timing postEvent for every reachable (configuration,
+ * event) pair of an FSM, and along random event sequences.
+ *
+ * A configuration is the active state, which gives the whole active
+ * state stack. Configurations are found breadth first from the start
+ * state, each is entered with FsmBase::reset. This assumes transitions
+ * depend on the state and event only, not on data in the FSM or state
+ * objects; random walks cover paths where that data matters.
+ *
+ * Each (configuration, event) pair keeps its worst time and the event
+ * path from the start state that led to it. Pairs where a handler
+ * allocated are flagged, see fsmAllocCounter.
+ *
+ * MyFsm fsm;
+ * FsmExplorer<MyFsm> ex(fsm, StateId::idle, {evA, evB, evC});
+ * ex.exploreAll(10);
+ * ex.randomWalks(100, 1000, 1);
+ * ex.report(std::cout);
+ *
+ * @param Clock Type with a static now() returning ticks, e.g. a cycle
+ *              counter. Defaults to steady_clock nanoseconds.
+ */
+template <class Fsm, class Clock = FsmSteadyClock>
+class FsmExplorer
+{
+  public:
+    using Event = typename Fsm::Event;
+    using StateId = typename Fsm::StateId;
+
+    // Worst run seen for one (configuration, event) pair.
+    struct Run
+    {
+        StateId from;
+        int event; // Index into the event list.
+        StateId to;
+        uint64_t ticks;
+        long allocations;
+        // Event indexes leading from the start state to 'from'.
+        std::vector<int> path;
+    };
+
+    FsmExplorer(Fsm& fsm, StateId start, std::vector<Event> events)
+        : m_fsm(fsm), m_start(start), m_events(std::move(events)),
+          m_runs(stateNo * m_events.size()), m_seen(stateNo * m_events.size())
+    {
+    }
+
+    /**
+     * Run every event in every reachable configuration, 'repeats' times
+     * each.
+     */
+    void exploreAll(int repeats = 1)
+    {
+        // Path to each configuration, empty if not yet reached.
+        std::vector<std::vector<int>> paths(stateNo);
+        std::vector<bool> reached(stateNo);
+        std::vector<StateId> queue{m_start};
+        reached[index(m_start)] = true;
+        warmUp();
+
+        for (size_t q = 0; q < queue.size(); ++q)
+        {
+            const StateId from = queue[q];
+            for (int ev = 0; ev < eventNo(); ++ev)
+            {
+                for (int r = 0; r < repeats; ++r)
+                {
+                    m_fsm.reset(from);
+                    measure(from, ev, paths[index(from)]);
+                }
+                const StateId to = m_fsm.currentStateId();
+                if (to != Fsm::nullStateId() && !reached[index(to)])
+                {
+                    reached[index(to)] = true;
+                    paths[index(to)] = paths[index(from)];
+                    paths[index(to)].push_back(ev);
+                    queue.push_back(to);
+                }
+            }
+        }
+        m_reachable = queue;
+    }
+
+    /**
+     * Run 'walks' sequences of 'length' random events from the start
+     * state. The same seed gives the same sequences.
+     */
+    void randomWalks(int walks, int length, unsigned seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<int> pick(0, eventNo() - 1);
+        warmUp();
+        std::vector<int> path;
+        for (int w = 0; w < walks; ++w)
+        {
+            m_fsm.reset(m_start);
+            path.clear();
+            for (int i = 0; i < length; ++i)
+            {
+                const StateId from = m_fsm.currentStateId();
+                if (from == Fsm::nullStateId())
+                    break;
+                const int ev = pick(rng);
+                measure(from, ev, path);
+                path.push_back(ev);
+            }
+        }
+    }
+
+    /// Configurations found by exploreAll, in breadth first order.
+    const std::vector<StateId>& reachable() const
+    {
+        return m_reachable;
+    }
+
+    /// All measured pairs, worst first.
+    std::vector<Run> results() const
+    {
+        std::vector<Run> res;
+        for (size_t i = 0; i < m_runs.size(); ++i)
+            if (m_seen[i])
+                res.push_back(m_runs[i]);
+        std::sort(res.begin(), res.end(), [](const Run& a, const Run& b) {
+            return a.ticks > b.ticks;
+        });
+        return res;
+    }
+
+    /// Pairs where a handler allocated.
+    std::vector<Run> allocating() const
+    {
+        std::vector<Run> res = results();
+        res.erase(std::remove_if(res.begin(), res.end(),
+                                 [](const Run& r) { return !r.allocations; }),
+                  res.end());
+        return res;
+    }
+
+    /**
+     * Write the 'top' worst pairs and all allocating pairs. States and
+     * events are given by their number.
+     */
+    void report(std::ostream& os, size_t top = 10) const
+    {
+        auto print = [&](const Run& r) {
+            os << "state " << index(r.from) << " event " << r.event
+               << " -> " << index(r.to) << ": " << r.ticks << " ticks, "
+               << r.allocations << " allocations, path";
+            for (int ev : r.path)
+                os << ' ' << ev;
+            os << '\n';
+        };
+        const std::vector<Run> res = results();
+        os << "worst run to completion:\n";
+        for (size_t i = 0; i < res.size() && i < top; ++i)
+            print(res[i]);
+        const std::vector<Run> allocs = allocating();
+        if (!allocs.empty())
+            os << "allocating handlers:\n";
+        for (const Run& r : allocs)
+            print(r);
+    }
+
+  private:
+    enum
+    {
+        stateNo = Fsm::stateNo,
+    };
+
+    static int index(StateId id)
+    {
+        return static_cast<int>(id);
+    }
+
+    int eventNo() const
+    {
+        return static_cast<int>(m_events.size());
+    }
+
+    // Let the queue reach its working capacity before counting
+    // allocations.
+    void warmUp()
+    {
+        m_fsm.reset(m_start);
+        if (!m_events.empty())
+            m_fsm.postEvent(m_events[0]);
+    }
+
+    void measure(StateId from, int ev, const std::vector<int>& path)
+    {
+        const long allocs = fsmAllocCounter().load();
+        const uint64_t t0 = Clock::now();
+        m_fsm.postEvent(m_events[ev]);
+        const uint64_t ticks = Clock::now() - t0;
+        const long newAllocs = fsmAllocCounter().load() - allocs;
+
+        const size_t i = index(from) * m_events.size() + ev;
+        Run& run = m_runs[i];
+        if (!m_seen[i] || ticks > run.ticks)
+        {
+            run.from = from;
+            run.event = ev;
+            run.to = m_fsm.currentStateId();
+            run.ticks = ticks;
+            run.path = path;
+        }
+        run.allocations = std::max(m_seen[i] ? run.allocations : 0, newAllocs);
+        m_seen[i] = true;
+    }
+
+    Fsm& m_fsm;
+    StateId m_start;
+    std::vector<Event> m_events;
+    std::vector<Run> m_runs;
+    std::vector<bool> m_seen;
+    std::vector<StateId> m_reachable;
+};
+
+#endif /* SRC_STATECHART_FSMEXPLORER_H_ */
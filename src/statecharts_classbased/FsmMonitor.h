@@ -0,0 +1,142 @@
+/*
+ * FsmMonitor.h
+ *
+ *  Lock free publication of FSM state to monitoring threads.
+ */
+
+#ifndef SRC_UTILITY_FSMMONITOR_H_
+#define SRC_UTILITY_FSMMONITOR_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * State of one FSM as seen by a monitor.
+ */
+struct FsmSnapshot
+{
+    // Active state id, -1 (nullStateId) if not started.
+    int32_t stateId;
+
+    // Number of state publications so far. The FSM publishes on start,
+    // on each transition and on stop or reset, so a stop followed by a
+    // restart advances it by two.
+    uint32_t sequence;
+
+    // Number of state to state transitions the FSM has made. Not changed
+    // by start, stop or attaching the slot.
+    uint32_t transitions;
+
+    // Clock ticks at the last publication.
+    uint64_t timestamp;
+};
+
+/**
+ * Default clock for FsmStateSlot. Any type with a static 'now()' returning
+ * an integral tick count works, e.g. a cycle counter.
+ */
+struct FsmSteadyClock
+{
+    static uint64_t now()
+    {
+        return static_cast<uint64_t>(
+            std::chrono::steady_clock::now().time_since_epoch().count());
+    }
+};
+
+/**
+ * Seqlock protected (state id, transitions, sequence, timestamp), written
+ * by the thread running the FSM and read by any number of other threads.
+ *
+ * MyFsm fsm;
+ * FsmStateSlot<> slot;
+ * fsm.publishTo(&slot);
+ *
+ * The writer never waits. 'stateId()' is a single atomic load. 'snapshot()'
+ * retries only if it overlaps a publication, so readers never block the
+ * FSM. The sequence counts publications and wraps after 2^31, the
+ * transition count is the FSM's own and counts only real transitions.
+ *
+ * For monitoring many FSMs, keep the slots in one array and scan it with
+ * exportSnapshots. Slots are 24 bytes, place FSMs driven by different
+ * threads in different cache lines if the writes are frequent.
+ */
+template <class Clock = FsmSteadyClock>
+class FsmStateSlot
+{
+  public:
+    FsmStateSlot() = default;
+    FsmStateSlot(const FsmStateSlot&) = delete;
+    FsmStateSlot& operator=(const FsmStateSlot&) = delete;
+
+    // Writer side, called by the FSM on each state change, including
+    // start, stop and reset.
+    void publish(int stateId, uint32_t transitions)
+    {
+        const uint64_t now = Clock::now();
+        const uint32_t seq = m_seq.load(std::memory_order_relaxed);
+        m_seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_stateId.store(stateId, std::memory_order_relaxed);
+        m_transitions.store(transitions, std::memory_order_relaxed);
+        m_timestamp.store(now, std::memory_order_relaxed);
+        m_seq.store(seq + 2, std::memory_order_release);
+    }
+
+    // Latest published state id. Wait free.
+    int32_t stateId() const
+    {
+        return m_stateId.load(std::memory_order_relaxed);
+    }
+
+    // Consistent copy of all fields.
+    FsmSnapshot snapshot() const
+    {
+        for (;;)
+        {
+            const uint32_t seq = m_seq.load(std::memory_order_acquire);
+            FsmSnapshot res;
+            res.stateId = m_stateId.load(std::memory_order_relaxed);
+            res.transitions = m_transitions.load(std::memory_order_relaxed);
+            res.timestamp = m_timestamp.load(std::memory_order_relaxed);
+            res.sequence = seq / 2;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (!(seq & 1) && m_seq.load(std::memory_order_relaxed) == seq)
+                return res;
+        }
+    }
+
+  private:
+    std::atomic<uint32_t> m_seq{0};
+    std::atomic<int32_t> m_stateId{-1};
+    std::atomic<uint32_t> m_transitions{0};
+    std::atomic<uint64_t> m_timestamp{0};
+};
+
+/**
+ * Copy snapshots of 'count' slots into 'out'.
+ */
+template <class Clock>
+void
+exportSnapshots(const FsmStateSlot<Clock>* slots, std::size_t count,
+                FsmSnapshot* out)
+{
+    for (std::size_t i = 0; i < count; ++i)
+        out[i] = slots[i].snapshot();
+}
+
+/**
+ * Same for slots spread out in memory, e.g. one member slot per FSM.
+ */
+template <class Clock>
+void
+exportSnapshots(const FsmStateSlot<Clock>* const* slots, std::size_t count,
+                FsmSnapshot* out)
+{
+    for (std::size_t i = 0; i < count; ++i)
+        out[i] = slots[i]->snapshot();
+}
+
+#endif /* SRC_UTILITY_FSMMONITOR_H_ */
@@ -0,0 +1,99 @@
+/*
+ * FsmPool.h
+ *
+ *  Fixed size pool of reusable FSM instances.
+ */
+
+#ifndef SRC_UTILITY_FSMPOOL_H_
+#define SRC_UTILITY_FSMPOOL_H_
+
+#include "StateChart.h"
+
+#include <cstddef>
+
+/**
+ * Pool of 'capacity' FSMs of type Fsm, constructed once. acquire() starts
+ * an idle FSM, release() stops it and returns it to the pool. Since FSMs
+ * are never destroyed, their state storage and queue capacity are
+ * allocated on first start only and reused after that.
+ *
+ * Released FSMs are reused last in, first out, so the next session gets
+ * the instance most likely to be in cache.
+ *
+ * User data in the Fsm class is not reset, initialize it in the start
+ * state or after acquire().
+ *
+ * Releasing an FSM not acquired from this pool, or releasing it twice,
+ * reports FsmError::badRelease.
+ */
+template <class Fsm, std::size_t capacity>
+class FsmPool
+{
+  public:
+    static_assert(capacity > 0, "");
+
+    FsmPool()
+    {
+        for (std::size_t i = 0; i < capacity; ++i)
+            m_free[i] = &m_fsms[capacity - 1 - i];
+    }
+
+    FsmPool(const FsmPool&) = delete;
+    FsmPool& operator=(const FsmPool&) = delete;
+
+    /**
+     * Take an idle FSM and start it in state 'id'. Return nullptr if all
+     * FSMs are in use.
+     */
+    Fsm* acquire(typename Fsm::StateId id)
+    {
+        if (m_freeNo == 0)
+            return nullptr;
+        Fsm* fsm = m_free[--m_freeNo];
+        m_inUse[fsm - m_fsms] = true;
+        fsm->setStartState(id);
+        return fsm;
+    }
+
+    /**
+     * Stop 'fsm', running exit handlers, and return it to the pool.
+     * Called from one of the FSM's own event handlers, the stop is
+     * deferred until the handler returns, see FsmBase::stop. Do not
+     * acquire() again before that.
+     */
+    void release(Fsm* fsm)
+    {
+        const std::size_t i = index(fsm);
+        if (i == capacity || !m_inUse[i])
+        {
+            fsmError(FsmError::badRelease);
+            return;
+        }
+        m_inUse[i] = false;
+        fsm->stop();
+        m_free[m_freeNo++] = fsm;
+    }
+
+    // Number of idle FSMs.
+    std::size_t available() const
+    {
+        return m_freeNo;
+    }
+
+  private:
+    // Index of 'fsm' in the pool, capacity if not from this pool.
+    std::size_t index(const Fsm* fsm) const
+    {
+        for (std::size_t i = 0; i < capacity; ++i)
+            if (fsm == &m_fsms[i])
+                return i;
+        return capacity;
+    }
+
+    Fsm m_fsms[capacity];
+    Fsm* m_free[capacity];
+    bool m_inUse[capacity] = {};
+    std::size_t m_freeNo = capacity;
+};
+
+#endif /* SRC_UTILITY_FSMPOOL_H_ */
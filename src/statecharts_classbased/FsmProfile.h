@@ -0,0 +1,129 @@
+/*
+ * FsmProfile.h
+ *
+ *  Transition and event counters for the statechart.
+ */
+
+#ifndef SRC_UTILITY_FSMPROFILE_H_
+#define SRC_UTILITY_FSMPROFILE_H_
+
+#include <atomic>
+#include <cstdint>
+
+#ifndef STATECHART_FREESTANDING
+#include <ostream>
+#endif
+
+/**
+ * Counters shared by all FSMs of one type, enabled by compiling with
+ * STATECHART_PROFILE. Without it no counters exist and no code is added.
+ *
+ * Counted are transitions per (source, target) state, where starts have
+ * nullStateId as source, and event handler calls per (state, event id).
+ * Event ids come from FsmEventTraits<Event>::id, the variant index for
+ * std::variant events and 0 otherwise.
+ *
+ * Increments are a relaxed load and store rather than an atomic add. No
+ * locked instructions on the hot path, but counts may be lost when FSMs
+ * of the same type run on several threads at once. Good enough for
+ * finding the hot paths.
+ */
+class FsmProfileData
+{
+  public:
+    using Counter = std::atomic<uint32_t>;
+
+    FsmProfileData() = default;
+
+    /**
+     * @param transitions (stateNo + 1) * stateNo zeroed counters.
+     * @param events stateNo * eventIdNo zeroed counters.
+     */
+    FsmProfileData(Counter* transitions, Counter* events, int stateNo,
+                   int eventIdNo)
+        : m_transitions(transitions), m_events(events), m_stateNo(stateNo),
+          m_eventIdNo(eventIdNo)
+    {
+    }
+
+    void countTransition(int from, int to) const
+    {
+        bump(m_transitions[row(from) * m_stateNo + to]);
+    }
+
+    void countEvent(int state, int eventId) const
+    {
+        bump(m_events[state * m_eventIdNo + eventId]);
+    }
+
+    uint32_t transitionCount(int from, int to) const
+    {
+        return m_transitions[row(from) * m_stateNo + to].load(
+            std::memory_order_relaxed);
+    }
+
+    uint32_t eventCount(int state, int eventId) const
+    {
+        return m_events[state * m_eventIdNo + eventId].load(
+            std::memory_order_relaxed);
+    }
+
+    int stateNo() const
+    {
+        return m_stateNo;
+    }
+
+    int eventIdNo() const
+    {
+        return m_eventIdNo;
+    }
+
+    void reset() const
+    {
+        for (int i = 0; i < (m_stateNo + 1) * m_stateNo; ++i)
+            m_transitions[i].store(0, std::memory_order_relaxed);
+        for (int i = 0; i < m_stateNo * m_eventIdNo; ++i)
+            m_events[i].store(0, std::memory_order_relaxed);
+    }
+
+  private:
+    // Starts are kept in the row after the last state.
+    int row(int from) const
+    {
+        return from < 0 ? m_stateNo : from;
+    }
+
+    static void bump(Counter& c)
+    {
+        c.store(c.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+    }
+
+    Counter* m_transitions = nullptr;
+    Counter* m_events = nullptr;
+    int m_stateNo = 0;
+    int m_eventIdNo = 0;
+};
+
+#ifndef STATECHART_FREESTANDING
+/**
+ * Write all non zero counters, one per line:
+ *   transition <from> <to> <count>
+ *   event <state> <event id> <count>
+ * States are given by their id, -1 for the start pseudo state.
+ */
+inline void
+writeProfile(std::ostream& os, const FsmProfileData& p)
+{
+    for (int from = -1; from < p.stateNo(); ++from)
+        for (int to = 0; to < p.stateNo(); ++to)
+            if (auto c = p.transitionCount(from, to))
+                os << "transition " << from << ' ' << to << ' ' << c << '\n';
+    for (int st = 0; st < p.stateNo(); ++st)
+        for (int ev = 0; ev < p.eventIdNo(); ++ev)
+            if (auto c = p.eventCount(st, ev))
+                os << "event " << st << ' ' << ev << ' ' << c << '\n';
+}
+#endif
+
+#endif /* SRC_UTILITY_FSMPROFILE_H_ */
@@ -0,0 +1,184 @@
+/*
+ * IntrusiveQueue.h
+ *
+ *  Event queue linking events through a hook embedded in each event.
+ */
+
+#ifndef SRC_UTILITY_INTRUSIVEQUEUE_H_
+#define SRC_UTILITY_INTRUSIVEQUEUE_H_
+
+#include <cstddef>
+#include <new>
+
+/**
+ * Link and owner information embedded in an event, by inheriting it.
+ * After dispatch the queue calls 'm_release' to hand the event back to
+ * its owner, e.g. the pool it came from. No release function means the
+ * producer keeps ownership and must keep the event alive until then.
+ */
+struct IntrusiveHook
+{
+    using Release = void (*)(IntrusiveHook* hook, void* owner);
+
+    IntrusiveHook* m_next = nullptr;
+    Release m_release = nullptr;
+    void* m_owner = nullptr;
+};
+
+/**
+ * FSM event queue of Msg pointers, where Msg inherits IntrusiveHook. Push
+ * and pop link and unlink in O(1) without allocating or copying the
+ * event. Use with 'using Event = Msg*; using Queue = IntrusiveQueue<Msg>;'.
+ *
+ * A Msg can only be in one queue at a time. The queue never gets full.
+ */
+template <class Msg>
+class IntrusiveQueue
+{
+  public:
+    IntrusiveQueue() = default;
+    IntrusiveQueue(const IntrusiveQueue&) = delete;
+    IntrusiveQueue& operator=(const IntrusiveQueue&) = delete;
+
+    ~IntrusiveQueue()
+    {
+        clear();
+    }
+
+    void push(Msg* const& msg)
+    {
+        IntrusiveHook* hook = msg;
+        hook->m_next = nullptr;
+        if (m_tail)
+            m_tail->m_next = hook;
+        else
+            m_head = msg;
+        m_tail = msg;
+    }
+
+    // Unlink the front event and release it to its owner.
+    void pop()
+    {
+        IntrusiveHook* hook = m_head;
+        m_head = static_cast<Msg*>(hook->m_next);
+        if (!m_head)
+            m_tail = nullptr;
+        hook->m_next = nullptr;
+        if (hook->m_release)
+            hook->m_release(hook, hook->m_owner);
+    }
+
+    Msg*& front()
+    {
+        return m_head;
+    }
+    Msg* const& front() const
+    {
+        return m_head;
+    }
+
+    bool empty() const
+    {
+        return m_head == nullptr;
+    }
+    bool full() const
+    {
+        return false;
+    }
+
+    // Release all events without dispatching them.
+    void clear()
+    {
+        while (!empty())
+            pop();
+    }
+
+  private:
+    Msg* m_head = nullptr;
+    Msg* m_tail = nullptr;
+};
+
+/**
+ * Fixed pool of 'capacity' Msg objects, handed out by acquire() and
+ * returned automatically when an IntrusiveQueue is done with them, or by
+ * release(). The free list reuses the hook link. Not thread safe, use
+ * from the FSM's thread. All events must be back in the pool when it is
+ * destroyed.
+ */
+template <class Msg, std::size_t capacity>
+class EventPool
+{
+  public:
+    EventPool()
+    {
+        for (std::size_t i = 0; i < capacity; ++i)
+            put(slot(i));
+    }
+
+    EventPool(const EventPool&) = delete;
+    EventPool& operator=(const EventPool&) = delete;
+
+    ~EventPool()
+    {
+        while (m_free)
+        {
+            Msg* msg = static_cast<Msg*>(m_free);
+            m_free = m_free->m_next;
+            msg->~Msg();
+        }
+    }
+
+    // Return a free event, nullptr if all are in use. The Msg object is
+    // reused as is, fields other than the hook keep their old values.
+    Msg* acquire()
+    {
+        if (!m_free)
+            return nullptr;
+        Msg* msg = static_cast<Msg*>(m_free);
+        m_free = m_free->m_next;
+        --m_available;
+        msg->m_next = nullptr;
+        msg->m_release = &releaseFkn;
+        msg->m_owner = this;
+        return msg;
+    }
+
+    void release(Msg* msg)
+    {
+        put(msg);
+    }
+
+    std::size_t available() const
+    {
+        return m_available;
+    }
+
+  private:
+    static void releaseFkn(IntrusiveHook* hook, void* owner)
+    {
+        static_cast<EventPool*>(owner)->put(static_cast<Msg*>(hook));
+    }
+
+    void put(Msg* msg)
+    {
+        msg->m_next = m_free;
+        m_free = msg;
+        ++m_available;
+    }
+
+    Msg* slot(std::size_t i)
+    {
+        return new (&m_store[i]) Msg();
+    }
+
+    struct alignas(Msg) Slot
+    {
+        unsigned char data[sizeof(Msg)];
+    };
+
+    Slot m_store[capacity];
+    IntrusiveHook* m_free = nullptr;
+    std::size_t m_available = 0;
+};
+
+#endif /* SRC_UTILITY_INTRUSIVEQUEUE_H_ */
@@ -0,0 +1,114 @@
+/*
+ * MpscQueue.h
+ *
+ *  Bounded lock free multi producer, single consumer queue.
+ */
+
+#ifndef SRC_UTILITY_MPSCQUEUE_H_
+#define SRC_UTILITY_MPSCQUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+/**
+ * Ring buffer of 'capacity' slots, each with a sequence number telling
+ * whether it is free or holds an element. Producers claim a slot with a
+ * CAS on the tail, then publish it by storing its sequence number. The
+ * single consumer needs no read-modify-write.
+ *
+ * push may be called from any thread, or an interrupt if std::atomic of
+ * size_t is lock free. pop, front and empty from the consumer only.
+ */
+template <class El, std::size_t capacity>
+class MpscQueue
+{
+  public:
+    static_assert(capacity >= 2 && (capacity & (capacity - 1)) == 0,
+                  "Capacity must be a power of two.");
+
+    MpscQueue()
+    {
+        for (std::size_t i = 0; i < capacity; ++i)
+            m_cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    ~MpscQueue()
+    {
+        while (!empty())
+            pop();
+    }
+
+    // Return false if the queue is full.
+    bool push(const El& el)
+    {
+        std::size_t pos = m_tail.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;)
+        {
+            cell = &m_cells[pos & mask];
+            const std::size_t seq = cell->seq.load(std::memory_order_acquire);
+            const intptr_t diff = intptr_t(seq) - intptr_t(pos);
+            if (diff == 0)
+            {
+                if (m_tail.compare_exchange_weak(pos, pos + 1,
+                                                 std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+        new (cell->data) El(el);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const
+    {
+        const Cell& cell = m_cells[m_head & mask];
+        return cell.seq.load(std::memory_order_acquire) != m_head + 1;
+    }
+
+    El& front()
+    {
+        return *reinterpret_cast<El*>(m_cells[m_head & mask].data);
+    }
+
+    void pop()
+    {
+        Cell& cell = m_cells[m_head & mask];
+        front().~El();
+        cell.seq.store(m_head + capacity, std::memory_order_release);
+        ++m_head;
+    }
+
+  private:
+    enum : std::size_t
+    {
+        mask = capacity - 1,
+    };
+
+    struct Cell
+    {
+        std::atomic<std::size_t> seq;
+        alignas(El) unsigned char data[sizeof(El)];
+    };
+
+    Cell m_cells[capacity];
+
+    // Producers and consumer on separate cache lines.
+    alignas(64) std::atomic<std::size_t> m_tail{0};
+    alignas(64) std::size_t m_head = 0;
+};
+
+#endif /* SRC_UTILITY_MPSCQUEUE_H_ */
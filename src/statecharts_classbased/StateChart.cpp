@@ -7,9 +7,62 @@
 
 #include "StateChart.h"
 
+#include <cstdlib>
+
+#if __cpp_exceptions
+#include <stdexcept>
+#endif
+
+namespace
+{
+FsmErrorHandler errorHandler = nullptr;
+}
+
+const char*
+toString(FsmError error)
+{
+    switch (error)
+    {
+    case FsmError::noParent:
+        return "No parent available for root states.";
+    case FsmError::parentMismatch:
+        return "Type mismatch for parent state.";
+    case FsmError::queueFull:
+        return "Event queue full.";
+    case FsmError::badRelease:
+        return "FSM released to a pool it was not acquired from.";
+    }
+    return "";
+}
+
+FsmErrorHandler
+setFsmErrorHandler(FsmErrorHandler handler)
+{
+    FsmErrorHandler old = errorHandler;
+    errorHandler = handler;
+    return old;
+}
+
+void
+fsmError(FsmError error)
+{
+    if (errorHandler)
+    {
+        errorHandler(error);
+        if (error == FsmError::queueFull)
+            return;
+    }
+#if __cpp_exceptions
+    throw std::runtime_error(toString(error));
+#else
+    std::abort();
+#endif
+}
+
 void
 FsmStaticData::addStateBase(int stateId, int parentId, size_t size,
-                            CreateFkn fkn)
+                            CreateFkn fkn, uint64_t eventMask,
+                            const SubMount* mount)
 {
     int level = 0;
     if (stateId != parentId)
@@ -17,13 +70,13 @@ FsmStaticData::addStateBase(int stateId, int parentId, size_t size,
         auto parent = findState(parentId);
         level = parent->m_level + 1;
     }
-    while (static_cast<int>(m_objectSizes.size()) <= level)
-        m_objectSizes.push_back(0);
+    if (m_levels <= level)
+        m_levels = level + 1;
 
-    if (m_objectSizes[level] < size)
-        m_objectSizes[level] = size;
+    if (m_levelSizes[level] < size)
+        m_levelSizes[level] = size;
 
-    m_states[stateId] = StateInfo(parentId, level, fkn);
+    m_states[stateId] = StateInfo(parentId, level, fkn, eventMask, mount);
 }
 
 void
@@ -35,7 +88,13 @@ FsmBaseMember::possiblyDoTransition(FsmBaseBase* fbb)
         m_nextState = FsmStaticData::nullStateId;
         if (i)
         {
+#ifdef STATECHART_PROFILE
+            m_setup.profile().countTransition(activeStateId(),
+                                              m_setup.findState(i));
+#endif
             doTransition(i, fbb);
+            m_transitions++;
+            notify();
         }
     }
 }
@@ -43,16 +102,20 @@ FsmBaseMember::possiblyDoTransition(FsmBaseBase* fbb)
 void
 FsmBaseMember::doEntry(const StateInfo* newState, FsmBaseBase* fsm)
 {
-    int level = newState->m_level;
-    auto& frame = m_stackFrames[level];
-    auto& storeVec = frame.m_stateStorage;
-    frame.m_activeState.reset(newState->m_maker(storeVec.get(), fsm));
+    auto& frame = m_levelData[newState->m_level];
+    StateArgs args(fsm, newState->m_mount);
+    frame.m_activeState = newState->m_maker(frame.m_stateStorage, args);
 };
 
 void
 FsmBaseMember::doExit(const StateInfo* currState)
 {
-    m_stackFrames[currState->m_level].m_activeState.reset(nullptr);
+    auto& frame = m_levelData[currState->m_level];
+    if (frame.m_activeState)
+    {
+        frame.m_activeState->~ModelBase();
+        frame.m_activeState = nullptr;
+    }
 }
 
 void
@@ -149,20 +212,50 @@ FsmBaseMember::cleanup()
     }
     doExit(m_currentInfo);
     m_currentInfo = nullptr;
+    notify();
+}
+
+FsmBaseMember::~FsmBaseMember()
+{
+    cleanup();
+    ::operator delete(m_levelData);
 }
 
 void
-FsmBaseMember::setStartState(int id, FsmBaseBase* fsm)
+FsmBaseMember::allocate()
 {
-    m_currentInfo = nullptr;
-    const auto& sizes = m_setup.sizes();
-    m_stackFrames.clear();
-    m_stackFrames.reserve(sizes.size());
-    for (const auto& el : sizes)
+    // Layout: LevelData for all levels, followed by the state storage of
+    // each level. Each part aligned for any type.
+    const size_t align = alignof(std::max_align_t);
+    auto roundUp = [=](size_t s) { return (s + align - 1) / align * align; };
+
+    const int levels = m_setup.levels();
+    size_t total = roundUp(levels * sizeof(LevelData));
+    for (int i = 0; i < levels; ++i)
+        total += roundUp(m_setup.levelSize(i));
+
+    char* block = static_cast<char*>(::operator new(total));
+    m_levelData = reinterpret_cast<LevelData*>(block);
+    char* storage = block + roundUp(levels * sizeof(LevelData));
+    for (int i = 0; i < levels; ++i)
     {
-        m_stackFrames.emplace_back(el);
+        m_levelData[i] = LevelData{nullptr, nullptr, storage};
+        storage += roundUp(m_setup.levelSize(i));
     }
+    m_storageSize = total;
+}
+
+void
+FsmBaseMember::setStartState(int id, FsmBaseBase* fsm)
+{
+    cleanup();
+    if (!m_levelData)
+        allocate();
+#ifdef STATECHART_PROFILE
+    m_setup.profile().countTransition(FsmStaticData::nullStateId, id);
+#endif
     setupTransition(m_setup.findState(id), fsm);
+    notify();
 }
 
 ModelBase*
@@ -170,11 +263,17 @@ FsmBaseMember::parent(int parentId)
 {
     const StateInfo* myInfo = m_currentInfo;
     if (myInfo->m_level == 0)
-        throw std::runtime_error("No parent available for root states.");
+    {
+        fsmError(FsmError::noParent);
+        std::abort();
+    }
 
     // Make sure the supplied type is the same as the active stack type.
     if (parentId != myInfo->m_parentId)
-        throw std::runtime_error("Type mismatch for parent state.");
+    {
+        fsmError(FsmError::parentMismatch);
+        std::abort();
+    }
 
     ModelBase* mb = getModelBase(myInfo->m_level - 1);
     return mb;
@@ -42,19 +42,78 @@
  * The statechart allocates memory for each level and this is reused for each
  * state change by using placement new/delete. This should ensure deterministic
  * timing for all state changes.
+ *
+ * When compiled as C++17, 'Event' may be a std::variant of message types.
+ * States then implement one 'event' overload per message type they handle,
+ * e.g. 'bool event(const Tick&)'. A state may also take the whole variant
+ * as a catch all. Levels whose state does not handle the message type are
+ * skipped without a call. See fsm_variant_test.cpp.
+ *
+ * The header has no dependency on iostream, exceptions or RTTI. Usage
+ * errors are reported to a handler set with setFsmErrorHandler. Without
+ * a handler, errors throw std::runtime_error, or call std::abort when
+ * exceptions are disabled. The event queue type is selected by
+ * 'FsmDesc::Queue', defaulting to VecQueue. Defining
+ * STATECHART_FREESTANDING drops VecQueue and std::vector, each FSM must
+ * then declare a Queue, e.g. 'using Queue = FixedQueue<Event, 8>;'.
+ * IntrusiveQueue passes large events by link without copying them.
+ * 'make size' reports the flash and RAM cost of a small FSM.
+ *
+ * Defining STATECHART_PROFILE adds transition and event counters per FSM
+ * type, see FsmProfile.h and FsmBase::profile().
  */
 
+#include "FixedQueue.h"
+
+#ifdef STATECHART_PROFILE
+#include "FsmProfile.h"
+#endif
+
+#ifndef STATECHART_FREESTANDING
 #include "VecQueue.h"
+#endif
 
-#include <algorithm>
-#include <functional>
-#include <memory>
-#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <new>
 
-#include <cassert>
-#include <iostream>
+#if __cplusplus >= 201703L
+#include <type_traits>
+#include <utility>
+#include <variant>
+#endif
 
 class FsmBaseBase;
+struct SubMount;
+
+/**
+ * Usage errors detected by the statechart.
+ */
+enum class FsmError
+{
+    noParent,       // parent() called from a root state.
+    parentMismatch, // parent() called with a state that is not the parent.
+    queueFull,      // Event posted to a full queue. The event is dropped.
+    badRelease,     // FsmPool::release of an FSM not acquired from it.
+};
+
+const char* toString(FsmError error);
+
+/**
+ * Signature of the error handler. For queueFull the handler may return
+ * and the event is dropped. For the other errors the FSM can not continue,
+ * if the handler returns std::abort is called.
+ */
+using FsmErrorHandler = void (*)(FsmError error);
+
+/**
+ * Set the error handler for all FSM:s. nullptr restores the default.
+ * Return the previous handler.
+ */
+FsmErrorHandler setFsmErrorHandler(FsmErrorHandler handler);
+
+// Report an error to the current handler.
+void fsmError(FsmError error);
 
 /**
  * Bundle of arguments passed from the FSM down to StateBase when constructing
@@ -62,9 +121,15 @@ class FsmBaseBase;
  */
 struct StateArgs
 {
-    StateArgs(FsmBaseBase* fsmBase) : m_fsmBase(fsmBase) {}
+    StateArgs(FsmBaseBase* fsmBase, const SubMount* mount = nullptr)
+        : m_fsmBase(fsmBase), m_mount(mount)
+    {
+    }
 
     FsmBaseBase* m_fsmBase;
+
+    // Mount point for submachine states, see Submachine.h.
+    const SubMount* m_mount;
 };
 
 /**
@@ -138,6 +203,157 @@ class StateBase
     Fsm* m_fsm;
 };
 
+/**
+ * Event dispatch to a state. The default delivers a single Event type to
+ * 'bool event(const Event&)' in each state.
+ *
+ * A Mask has one bit per event type. Each state records the types it
+ * handles so the FSM can skip states that ignore an event.
+ *
+ * 'id' numbers events from 0 to idNo - 1 for profiling. To profile per
+ * event, specialize FsmEventTraits for the event class, inheriting
+ * FsmEventTraitsBase and redefining idNo and id.
+ */
+template <class Event>
+struct FsmEventTraitsBase
+{
+    using Mask = uint64_t;
+
+    enum
+    {
+        idNo = 1
+    };
+
+    static int id(const Event&)
+    {
+        return 0;
+    }
+
+    static Mask bit(const Event&)
+    {
+        return 1;
+    }
+
+    template <class State>
+    static constexpr Mask handledMask()
+    {
+        return ~Mask(0);
+    }
+
+    template <class State>
+    static bool dispatch(State& st, const Event& ev)
+    {
+        return st.event(ev);
+    }
+};
+
+template <class Event>
+struct FsmEventTraits : FsmEventTraitsBase<Event>
+{
+};
+
+#if __cplusplus >= 201703L
+/**
+ * Dispatch of std::variant events. Each alternative is delivered to the
+ * state's overload for that exact type, or to an overload taking the whole
+ * variant. Dispatch is through a compile time table indexed on the active
+ * alternative.
+ */
+template <class... Msgs>
+struct FsmEventTraits<std::variant<Msgs...>>
+{
+    using Event = std::variant<Msgs...>;
+    using Mask = uint64_t;
+
+    static_assert(sizeof...(Msgs) <= 64, "At most 64 event types.");
+
+    enum
+    {
+        idNo = sizeof...(Msgs)
+    };
+
+    static int id(const Event& ev)
+    {
+        return static_cast<int>(ev.index());
+    }
+
+    static Mask bit(const Event& ev)
+    {
+        return Mask(1) << ev.index();
+    }
+
+    template <class State>
+    static constexpr Mask handledMask()
+    {
+        return mask<State>(std::index_sequence_for<Msgs...>());
+    }
+
+    template <class State>
+    static bool dispatch(State& st, const Event& ev)
+    {
+        using Table = DispatchTable<State, std::index_sequence_for<Msgs...>>;
+        return Table::fkns[ev.index()](st, ev);
+    }
+
+  private:
+    // Converts to 'const T&' only. Used to detect an overload for T itself
+    // rather than one reached through the variant converting constructor.
+    template <class T>
+    struct Exact
+    {
+        operator const T&() const;
+    };
+
+    template <class State, class T, class = void>
+    struct HasOverload : std::false_type
+    {
+    };
+
+    template <class State, class T>
+    struct HasOverload<State, T,
+                       std::void_t<decltype(std::declval<State&>().event(
+                           std::declval<T>()))>> : std::true_type
+    {
+    };
+
+    template <class State, std::size_t i>
+    static constexpr bool handles()
+    {
+        using Msg = std::variant_alternative_t<i, Event>;
+        return HasOverload<State, Exact<Msg>>::value ||
+               HasOverload<State, const Event&>::value;
+    }
+
+    template <class State, std::size_t... is>
+    static constexpr Mask mask(std::index_sequence<is...>)
+    {
+        return (Mask(0) | ... | (Mask(handles<State, is>()) << is));
+    }
+
+    template <class State, std::size_t i>
+    static bool call(State& st, const Event& ev)
+    {
+        using Msg = std::variant_alternative_t<i, Event>;
+        if constexpr (HasOverload<State, Exact<Msg>>::value)
+            return st.event(*std::get_if<i>(&ev));
+        else if constexpr (HasOverload<State, const Event&>::value)
+            return st.event(ev);
+        else
+            return false;
+    }
+
+    template <class State, class Seq>
+    struct DispatchTable;
+
+    template <class State, std::size_t... is>
+    struct DispatchTable<State, std::index_sequence<is...>>
+    {
+        static constexpr bool (*fkns[])(State&, const Event&) = {
+            &call<State, is>...};
+    };
+};
+#endif
+
 /**
  * Base for 'StateModel' class. StateModel keeps a State as a member and
  * introduce inheritance for event passing. Purpose of ModelBase is to get a
@@ -156,7 +372,16 @@ class ModelBase
 class FsmStaticData
 {
   public:
-    explicit FsmStaticData(int stateNo) : m_states(stateNo) {}
+    struct StateInfo;
+
+    /**
+     * @param states Array with one entry per state.
+     * @param levelSizes Array with one zero initialized entry per state.
+     */
+    FsmStaticData(StateInfo* states, size_t* levelSizes)
+        : m_states(states), m_levelSizes(levelSizes)
+    {
+    }
 
     static const constexpr int nullStateId = -1;
 
@@ -164,24 +389,31 @@ class FsmStaticData
      * Signature for the creator function for a particular state.
      * Called when entering a new state to construct the state object.
      * @param store  A memory array large enough to create the object on.
-     * @param fsm Pointer to the current fsm.
+     * @param args Arguments for the state constructor.
      * @return Pointer to the newly created Model object.
      */
-    using CreateFkn = ModelBase* (*)(char* store, FsmBaseBase* fsm);
+    using CreateFkn = ModelBase* (*)(char* store, const StateArgs& args);
 
     // Collection of meta data for one state.
     struct StateInfo
     {
         StateInfo() : m_maker(nullptr) {}
         template <class StateId>
-        StateInfo(StateId parentId, int level, const CreateFkn& fkn)
+        StateInfo(StateId parentId, int level, const CreateFkn& fkn,
+                  uint64_t eventMask, const SubMount* mount)
             : m_parentId(static_cast<int>(parentId)), m_level(level),
-              m_maker(fkn)
+              m_maker(fkn), m_eventMask(eventMask), m_mount(mount)
         {
         }
         int m_parentId;
         int m_level;
         CreateFkn m_maker;
+
+        // Event types handled by the state, see FsmEventTraits.
+        uint64_t m_eventMask;
+
+        // Mount point if this is a submachine state, otherwise nullptr.
+        const SubMount* m_mount;
     };
 
     const StateInfo* findState(int id) const
@@ -195,19 +427,45 @@ class FsmStaticData
         return si == nullptr ? nullStateId : (si - &m_states[0]);
     }
 
-    void addStateBase(int stateId, int parentId, size_t size, CreateFkn fkn);
+    void addStateBase(int stateId, int parentId, size_t size, CreateFkn fkn,
+                      uint64_t eventMask, const SubMount* mount = nullptr);
+
+    // Number of levels in the state hierarchy.
+    int levels() const
+    {
+        return m_levels;
+    }
+
+    // Maximum size of a state object at 'level'.
+    size_t levelSize(int level) const
+    {
+        return m_levelSizes[level];
+    }
 
-    const std::vector<size_t>& sizes() const
+#ifdef STATECHART_PROFILE
+    const FsmProfileData& profile() const
     {
-        return m_objectSizes;
+        return m_profile;
     }
 
+    void setProfile(const FsmProfileData& profile)
+    {
+        m_profile = profile;
+    }
+#endif
+
   private:
     // Store of the information structure for all the states.
-    std::vector<StateInfo> m_states;
+    StateInfo* m_states;
 
     // Store the maximum size needed for each level to construct the objects.
-    std::vector<size_t> m_objectSizes;
+    size_t* m_levelSizes;
+
+    int m_levels = 0;
+
+#ifdef STATECHART_PROFILE
+    FsmProfileData m_profile;
+#endif
 };
 
 class FsmBaseMember
@@ -216,10 +474,10 @@ class FsmBaseMember
     using StateInfo = FsmStaticData::StateInfo;
     FsmBaseMember(const FsmStaticData& setup) : m_setup(setup) {}
 
-    ~FsmBaseMember()
-    {
-        cleanup();
-    }
+    FsmBaseMember(const FsmBaseMember&) = delete;
+    FsmBaseMember& operator=(const FsmBaseMember&) = delete;
+
+    ~FsmBaseMember();
 
     void transition(int id)
     {
@@ -228,6 +486,13 @@ class FsmBaseMember
 
     void setStartState(int id, FsmBaseBase* hsm);
 
+    // Exit all active states. Storage is kept for the next start. Must not
+    // run inside an event handler, FsmBaseEvent::stop defers it.
+    void stop()
+    {
+        cleanup();
+    }
+
     const StateInfo* activeStateInfo() const
     {
         return m_currentInfo;
@@ -241,19 +506,55 @@ class FsmBaseMember
     // Return the working area for a particular level.
     ModelBase* getModelBase(int level)
     {
-        return m_stackFrames[level].m_activeState.get();
+        return m_levelData[level].m_activeState;
     }
 
     const ModelBase* getModelBase(int level) const
     {
-        return m_stackFrames[level].m_activeState.get();
+        return m_levelData[level].m_activeState;
     }
 
     void possiblyDoTransition(FsmBaseBase* fbb);
 
     const StateInfo* stateInfoAtLevel(int level) const
     {
-        return m_stackFrames[level].m_stateInfo;
+        return m_levelData[level].m_stateInfo;
+    }
+
+#ifdef STATECHART_PROFILE
+    // Count an event delivered to the active state at 'level'.
+    void countEvent(int level, int eventId) const
+    {
+        const int id = m_setup.findState(stateInfoAtLevel(level));
+        m_setup.profile().countEvent(id, eventId);
+    }
+#endif
+
+    // Bytes allocated for level data and state objects. 0 before start.
+    size_t storageSize() const
+    {
+        return m_storageSize;
+    }
+
+    // Number of completed state to state transitions. Start and stop are
+    // not transitions.
+    uint32_t transitionCount() const
+    {
+        return m_transitions;
+    }
+
+    /**
+     * Function called with the new state id and the transition count
+     * after every completed transition, and on start. Called with
+     * nullStateId when the FSM is stopped.
+     */
+    using TransitionHook = void (*)(void* context, int stateId,
+                                    uint32_t transitions);
+
+    void setTransitionHook(TransitionHook hook, void* context)
+    {
+        m_hook = hook;
+        m_hookContext = context;
     }
 
     // Given current state, return the ModelBase of the parent if available,
@@ -265,40 +566,32 @@ class FsmBaseMember
     const ModelBase* activeState(int targetId) const;
 
   private:
-    // Implement placement destruction for the smart pointer.
-    struct PlacementDestroyer
-    {
-        void operator()(ModelBase* p)
-        {
-            p->~ModelBase();
-        }
-    };
-
-    // Smart pointer type implementing the placement delete.
-    using UniquePtr = std::unique_ptr<ModelBase, PlacementDestroyer>;
-
     // Structure for one level of the state stack.
     struct LevelData
     {
-        explicit LevelData(size_t size)
-            : m_stateInfo(nullptr), m_activeState(nullptr),
-              m_stateStorage(std::make_unique<char[]>(size))
-        {
-        }
-
         // Active meta information pointer.
         const StateInfo* m_stateInfo;
 
-        // Current active state for this level.
-        UniquePtr m_activeState;
+        // Current active state for this level, placement constructed in
+        // m_stateStorage.
+        ModelBase* m_activeState;
 
         // Storage for the current active State object.
-        std::unique_ptr<char[]> m_stateStorage;
+        char* m_stateStorage;
     };
 
+    // Allocate level data and state storage as one block.
+    void allocate();
+
     // Do final exit handlers prior to destructing the fsm.
     void cleanup();
 
+    void notify()
+    {
+        if (m_hook)
+            m_hook(m_hookContext, activeStateId(), m_transitions);
+    }
+
     // Do initial entry calls when starting the fsm.
     void setupTransition(const StateInfo* nextInfo, FsmBaseBase* fsm);
 
@@ -311,10 +604,18 @@ class FsmBaseMember
 
     const StateInfo*& stateInfo(int level)
     {
-        return m_stackFrames[level].m_stateInfo;
+        return m_levelData[level].m_stateInfo;
     }
 
-    std::vector<LevelData> m_stackFrames;
+    // Start of the storage block, nullptr until started.
+    LevelData* m_levelData = nullptr;
+
+    size_t m_storageSize = 0;
+
+    TransitionHook m_hook = nullptr;
+    void* m_hookContext = nullptr;
+
+    uint32_t m_transitions = 0;
 
     const StateInfo* m_currentInfo = nullptr;
 
@@ -330,6 +631,9 @@ class FsmBaseBase
 
     ~FsmBaseBase() {}
 
+    template <typename SubDesc, typename SubDesc::StateId>
+    friend class SubStateBase;
+
     FsmBaseMember m_base;
 };
 
@@ -348,7 +652,8 @@ class StateModel : public EventInterface<typename FsmDesc::Event>
     StateModel(StateArgs args) : m_state(args) {}
     bool event(const typename FsmDesc::Event& event) override
     {
-        return m_state.event(event);
+        return FsmEventTraits<typename FsmDesc::Event>::dispatch(m_state,
+                                                                 event);
     }
     ~StateModel() override {}
 
@@ -364,8 +669,12 @@ template <class FsmDesc>
 class FsmSetup
 {
   public:
-    FsmSetup() : m_data(static_cast<int>(FsmDesc::StateId::stateIdNo))
+    FsmSetup() : m_levelSizes{}, m_data(m_states, m_levelSizes)
     {
+#ifdef STATECHART_PROFILE
+        m_data.setProfile(FsmProfileData(m_transitionCounts, m_eventCounts,
+                                         stateNo, eventIdNo));
+#endif
         FsmDesc::setupStates(*this);
     }
 
@@ -394,25 +703,79 @@ class FsmSetup
         static_assert(static_cast<int>(State::stateId) !=
                           FsmStaticData::nullStateId,
                       "state id is reserved.");
-        auto makerFkn = [](char* store, FsmBaseBase* fsm) -> ModelBase* {
-            auto p = new (store) StateModel<FsmDesc, State>(StateArgs(fsm));
+        auto makerFkn = [](char* store, const StateArgs& args) -> ModelBase* {
+            auto p = new (store) StateModel<FsmDesc, State>(args);
             return static_cast<ModelBase*>(p);
         };
+        using Traits = FsmEventTraits<typename FsmDesc::Event>;
         m_data.addStateBase(static_cast<int>(State::stateId),
                             static_cast<int>(ParentState::stateId),
-                            sizeof(StateModel<FsmDesc, State>), makerFkn);
+                            sizeof(StateModel<FsmDesc, State>), makerFkn,
+                            Traits::template handledMask<State>());
     }
 
+    /**
+     * Mount the submachine SubDesc under ParentState. Its states get the
+     * ids from 'base' and up, which must be a free range in StateId. When
+     * a submachine state leaves through exit i, the FSM goes to exits[i].
+     * Defined in Submachine.h.
+     */
+    template <class SubDesc, class ParentState,
+              typename FsmDesc::StateId base,
+              typename FsmDesc::StateId... exits>
+    void addSubmachine();
+
     const FsmStaticData& data()
     {
         return m_data;
     }
 
   private:
+    enum
+    {
+        stateNo = static_cast<int>(FsmDesc::StateId::stateIdNo),
+        eventIdNo = FsmEventTraits<typename FsmDesc::Event>::idNo,
+    };
+
+    FsmStaticData::StateInfo m_states[stateNo];
+    size_t m_levelSizes[stateNo];
     FsmStaticData m_data;
+
+#ifdef STATECHART_PROFILE
+    FsmProfileData::Counter m_transitionCounts[(stateNo + 1) * stateNo] = {};
+    FsmProfileData::Counter m_eventCounts[stateNo * eventIdNo] = {};
+#endif
 };
 
-template <class Event>
+template <class...>
+struct FsmVoid
+{
+    using type = void;
+};
+
+/**
+ * Select the event queue of an FSM: FsmDesc::Queue if declared, otherwise
+ * VecQueue<Event>. A queue needs push, pop, front, empty, full and
+ * clear.
+ */
+template <class FsmDesc, class = void>
+struct FsmQueue
+{
+#ifdef STATECHART_FREESTANDING
+    static_assert(sizeof(FsmDesc) == 0,
+                  "Freestanding FSM needs FsmDesc::Queue, e.g. FixedQueue.");
+#else
+    using type = VecQueue<typename FsmDesc::Event>;
+#endif
+};
+
+template <class FsmDesc>
+struct FsmQueue<FsmDesc, typename FsmVoid<typename FsmDesc::Queue>::type>
+{
+    using type = typename FsmDesc::Queue;
+};
+
+template <class Event, class Queue>
 class FsmBaseEvent : public FsmBaseBase
 {
   public:
@@ -423,7 +786,7 @@ class FsmBaseEvent : public FsmBaseBase
     void postEvent(const Event& ev)
     {
         bool empty = m_eventQueue.empty();
-        m_eventQueue.push(ev);
+        addEvent(ev);
         if (empty)
         { // Nobody else is currently processing events.
             processQueue();
@@ -433,12 +796,22 @@ class FsmBaseEvent : public FsmBaseBase
     // Add an event to the queue without processing it.
     void addEvent(const Event& ev)
     {
-        m_eventQueue.push(ev);
+        if (m_eventQueue.full())
+            fsmError(FsmError::queueFull);
+        else
+            m_eventQueue.push(ev);
+    }
+
+    // Drop all queued events.
+    void clearQueue()
+    {
+        m_eventQueue.clear();
     }
 
     // Process the queue.
     void processQueue()
     {
+        m_processing = true;
         while (!m_eventQueue.empty())
         {
             // Keep a local copy in case the vector reallocate during the
@@ -446,7 +819,30 @@ class FsmBaseEvent : public FsmBaseBase
             Event ev = m_eventQueue.front();
             processEvent(ev);
             m_eventQueue.pop();
+            if (m_stopPending)
+            {
+                m_stopPending = false;
+                m_processing = false;
+                stop();
+                return;
+            }
         }
+        m_processing = false;
+    }
+
+  protected:
+    // Exit all states and drop queued events. From an event handler, the
+    // state object and the queue are still in use, so it is done when
+    // the handler returns.
+    void stop()
+    {
+        if (m_processing)
+        {
+            m_stopPending = true;
+            return;
+        }
+        clearQueue();
+        m_base.stop();
     }
 
   private:
@@ -456,12 +852,20 @@ class FsmBaseEvent : public FsmBaseBase
         if (!activeInfo)
             return;
 
+        const auto bit = FsmEventTraits<Event>::bit(ev);
         bool eventHandled = false;
         int level = activeInfo->m_level;
         while (!eventHandled && level >= 0)
         {
-            auto activeState = m_base.getModelBase(level);
-            eventHandled = emitEvent(activeState, ev);
+            // Skip states not handling this event type.
+            if (m_base.stateInfoAtLevel(level)->m_eventMask & bit)
+            {
+#ifdef STATECHART_PROFILE
+                m_base.countEvent(level, FsmEventTraits<Event>::id(ev));
+#endif
+                auto activeState = m_base.getModelBase(level);
+                eventHandled = emitEvent(activeState, ev);
+            }
             level--;
         }
         m_base.possiblyDoTransition(this);
@@ -472,15 +876,22 @@ class FsmBaseEvent : public FsmBaseBase
         return static_cast<EventInterface<Event>*>(sbb)->event(ev);
     }
 
-    VecQueue<Event> m_eventQueue;
+    Queue m_eventQueue;
+    bool m_processing = false;
+    bool m_stopPending = false;
 };
 
 /**
  * Base class for the custom FSM.
  */
 template <class FsmDesc>
-class FsmBase : public FsmBaseEvent<typename FsmDesc::Event>
+class FsmBase
+    : public FsmBaseEvent<typename FsmDesc::Event,
+                          typename FsmQueue<FsmDesc>::type>
 {
+    using EventBase = FsmBaseEvent<typename FsmDesc::Event,
+                                   typename FsmQueue<FsmDesc>::type>;
+
   public:
     using StateId = typename FsmDesc::StateId;
     using Event = typename FsmDesc::Event;
@@ -492,7 +903,7 @@ class FsmBase : public FsmBaseEvent<typename FsmDesc::Event>
         return static_cast<StateId>(FsmStaticData::nullStateId);
     }
 
-    FsmBase() : FsmBaseEvent<Event>(instance()) {}
+    FsmBase() : EventBase(instance()) {}
 
     ~FsmBase() = default;
 
@@ -505,6 +916,28 @@ class FsmBase : public FsmBaseEvent<typename FsmDesc::Event>
         FsmBaseBase::m_base.setStartState(static_cast<int>(id), this);
     }
 
+    /**
+     * Exit all active states, drop queued events and enter 'id' again.
+     * State storage and queue capacity are kept, so after the first start
+     * this does no allocation. Not to be called from an event handler.
+     */
+    void reset(StateId id)
+    {
+        stop();
+        setStartState(id);
+    }
+
+    /**
+     * Exit all active states and drop queued events. The FSM is back in
+     * nullStateId and can be started again. Called from an event handler,
+     * the stop is deferred until the handler and any transition it made
+     * are done, and the rest of the queue is dropped.
+     */
+    void stop()
+    {
+        EventBase::stop();
+    }
+
     /**
      * Return the identifier of the currently active state.
      */
@@ -513,6 +946,50 @@ class FsmBase : public FsmBaseEvent<typename FsmDesc::Event>
         return static_cast<StateId>(FsmBaseBase::m_base.activeStateId());
     }
 
+    // Completed state to state transitions since construction.
+    uint32_t transitionCount() const
+    {
+        return FsmBaseBase::m_base.transitionCount();
+    }
+
+    /**
+     * Publish the state to 'slot' now and after every state change (start,
+     * transition, stop and reset) by calling
+     * 'slot.publish(int stateId, uint32_t transitions)'. See FsmMonitor.h.
+     * Pass nullptr to stop.
+     * The slot must outlive the FSM or be removed before destruction.
+     */
+    template <class Slot>
+    void publishTo(Slot* slot)
+    {
+        FsmBaseMember::TransitionHook hook = [](void* ctx, int id,
+                                                uint32_t transitions) {
+            static_cast<Slot*>(ctx)->publish(id, transitions);
+        };
+        FsmBaseBase::m_base.setTransitionHook(slot ? hook : nullptr, slot);
+        if (slot)
+            slot->publish(FsmBaseBase::m_base.activeStateId(),
+                          FsmBaseBase::m_base.transitionCount());
+    }
+
+#ifdef STATECHART_PROFILE
+    /**
+     * Counters shared by all FSMs of this type, see FsmProfile.h.
+     */
+    static const FsmProfileData& profile()
+    {
+        return instance().profile();
+    }
+#endif
+
+    /**
+     * Bytes of state storage allocated for this FSM, 0 before start.
+     */
+    size_t storageSize() const
+    {
+        return FsmBaseBase::m_base.storageSize();
+    }
+
     /**
      * Return the current active state object. Do note that this
      * requires knowledge of the active state and it's type. If the
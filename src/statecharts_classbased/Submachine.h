@@ -0,0 +1,269 @@
+/*
+ * Submachine.h
+ *
+ *  Reusable sub graphs of states, mounted into several FSMs.
+ */
+
+#ifndef SRC_STATECHART_SUBMACHINE_H_
+#define SRC_STATECHART_SUBMACHINE_H_
+
+#include "StateChart.h"
+
+#include <type_traits>
+
+/**
+ * A submachine is a group of states written once against its own
+ * description class and mounted under a parent state in any number of
+ * FSMs, possibly several times in the same FSM.
+ *
+ * The description class gives:
+ * - 'StateId', the states of the submachine, ending with stateIdNo.
+ * - 'ExitId', the ways to leave the submachine, ending with exitIdNo.
+ * - 'Event', which must be the Event of every FSM it is mounted in.
+ * - 'Context', a class the FSM must inherit. Submachine states reach FSM
+ *   data through it, e.g. a retry count.
+ * - 'setupStates(SubSetup<SubDesc>&)', adding the states as usual.
+ *
+ * States inherit SubStateBase<SubDesc, id>. Transitions use the
+ * submachine's own ids, 'leave(ExitId)' goes to the FSM state given for
+ * that exit when mounting.
+ *
+ * In the FSM, reserve a range of ids and mount in setupStates:
+ *
+ *   enum class StateId { top, connect, retry,
+ *       retryLast = retry + int(RetryDesc::StateId::stateIdNo) - 1,
+ *       online, offline, stateIdNo };
+ *
+ *   sc.addSubmachine<RetryDesc, Connect, StateId::retry,
+ *                    StateId::online, StateId::offline>();
+ *
+ * The submachine state code and its state table are shared by all mount
+ * points. Each mount point adds one StateInfo per submachine state to the
+ * FSM's table, plus a small constant SubMount record.
+ */
+
+/**
+ * Where a submachine is mounted. One constant instance per mount point.
+ */
+struct SubMount
+{
+    // FSM state id of submachine state 0.
+    int base;
+
+    // FSM state id for each ExitId.
+    const int* exits;
+
+    // Return the FSM as SubDesc::Context*.
+    void* (*context)(FsmBaseBase* fsm);
+};
+
+/**
+ * State table of a submachine, built once per SubDesc. Ids are the
+ * submachine's own. Root states have themselves as parent.
+ */
+template <class SubDesc>
+class SubSetup
+{
+  public:
+    enum
+    {
+        stateNo = static_cast<int>(SubDesc::StateId::stateIdNo),
+    };
+
+    struct Entry
+    {
+        int id;
+        int parentId;
+        size_t size;
+        FsmStaticData::CreateFkn maker;
+        uint64_t eventMask;
+    };
+
+    template <class State>
+    void addState()
+    {
+        addState<State, State>();
+    }
+
+    template <class State, class ParentState>
+    void addState()
+    {
+        auto makerFkn = [](char* store, const StateArgs& args) -> ModelBase* {
+            auto p = new (store) StateModel<SubDesc, State>(args);
+            return static_cast<ModelBase*>(p);
+        };
+        using Traits = FsmEventTraits<typename SubDesc::Event>;
+        Entry& e = m_entries[m_count++];
+        e.id = static_cast<int>(State::stateId);
+        e.parentId = static_cast<int>(ParentState::stateId);
+        e.size = sizeof(StateModel<SubDesc, State>);
+        e.maker = makerFkn;
+        e.eventMask = Traits::template handledMask<State>();
+    }
+
+    const Entry* begin() const
+    {
+        return m_entries;
+    }
+
+    const Entry* end() const
+    {
+        return m_entries + m_count;
+    }
+
+    static const SubSetup& instance()
+    {
+        static SubSetup setup;
+        return setup;
+    }
+
+  private:
+    SubSetup()
+    {
+        SubDesc::setupStates(*this);
+    }
+
+    Entry m_entries[stateNo];
+    int m_count = 0;
+};
+
+/**
+ * Base class for submachine states. Same role as StateBase but with no
+ * knowledge of the FSM class.
+ */
+template <typename SubDesc, typename SubDesc::StateId stId>
+class SubStateBase
+{
+    SubStateBase() = delete;
+    SubStateBase(const SubStateBase& s) = delete;
+    SubStateBase& operator=(const SubStateBase& s) = delete;
+
+  public:
+    using FsmDescription = SubDesc;
+    using StateId = typename SubDesc::StateId;
+    using ExitId = typename SubDesc::ExitId;
+    using Context = typename SubDesc::Context;
+
+    static constexpr const StateId stateId = stId;
+
+    explicit SubStateBase(const StateArgs& args)
+        : m_fsm(args.m_fsmBase), m_mount(args.m_mount)
+    {
+    }
+
+    /**
+     * Transition to another state of the same submachine.
+     */
+    void transition(StateId id)
+    {
+        m_fsm->m_base.transition(m_mount->base + static_cast<int>(id));
+    }
+
+    template <typename TargetState>
+    void transition()
+    {
+        transition(TargetState::stateId);
+    }
+
+    /**
+     * Leave the submachine, going to the FSM state given for 'id' when
+     * mounting.
+     */
+    void leave(ExitId id)
+    {
+        m_fsm->m_base.transition(m_mount->exits[static_cast<int>(id)]);
+    }
+
+    /// FSM data shared with the submachine.
+    Context& context()
+    {
+        return *static_cast<Context*>(m_mount->context(m_fsm));
+    }
+
+    /// Parent state within the submachine.
+    template <class ParentState>
+    ParentState& parent()
+    {
+        const int id = m_mount->base + static_cast<int>(ParentState::stateId);
+        ModelBase* mb = m_fsm->m_base.parent(id);
+        return static_cast<StateModel<SubDesc, ParentState>*>(mb)->m_state;
+    }
+
+    /// Id of this state in the FSM it is mounted in.
+    int fsmStateId() const
+    {
+        return m_mount->base + static_cast<int>(stId);
+    }
+
+  private:
+    FsmBaseBase* m_fsm;
+    const SubMount* m_mount;
+};
+
+template <typename SubDesc, typename SubDesc::StateId stId>
+constexpr const typename SubDesc::StateId SubStateBase<SubDesc, stId>::stateId;
+
+namespace details
+{
+
+// Constant mount record for one mount point.
+template <class FsmDesc, class SubDesc, typename FsmDesc::StateId base,
+          typename FsmDesc::StateId... exits>
+struct SubMountFor
+{
+    static void* context(FsmBaseBase* fsm)
+    {
+        using Context = typename SubDesc::Context;
+        auto host = static_cast<typename FsmDesc::Fsm*>(fsm);
+        return static_cast<Context*>(host);
+    }
+
+    // Trailing entry avoids a zero size array.
+    static const int exitIds[sizeof...(exits) + 1];
+    static const SubMount mount;
+};
+
+template <class FsmDesc, class SubDesc, typename FsmDesc::StateId base,
+          typename FsmDesc::StateId... exits>
+const int SubMountFor<FsmDesc, SubDesc, base, exits...>::exitIds[] = {
+    static_cast<int>(exits)..., FsmStaticData::nullStateId};
+
+template <class FsmDesc, class SubDesc, typename FsmDesc::StateId base,
+          typename FsmDesc::StateId... exits>
+const SubMount SubMountFor<FsmDesc, SubDesc, base, exits...>::mount = {
+    static_cast<int>(base), exitIds, &context};
+
+} // namespace details
+
+template <class FsmDesc>
+template <class SubDesc, class ParentState, typename FsmDesc::StateId base,
+          typename FsmDesc::StateId... exits>
+void
+FsmSetup<FsmDesc>::addSubmachine()
+{
+    using Sub = SubSetup<SubDesc>;
+    static_assert(std::is_same<typename FsmDesc::Event,
+                               typename SubDesc::Event>::value,
+                  "Submachine and FSM need the same Event type.");
+    static_assert(std::is_base_of<typename SubDesc::Context,
+                                  typename FsmDesc::Fsm>::value,
+                  "FSM must inherit the submachine Context.");
+    static_assert(sizeof...(exits) ==
+                      static_cast<int>(SubDesc::ExitId::exitIdNo),
+                  "Give one target state per exit.");
+    static_assert(static_cast<int>(base) + Sub::stateNo <= stateNo,
+                  "Id range for the submachine is outside StateId.");
+
+    using Mount = details::SubMountFor<FsmDesc, SubDesc, base, exits...>;
+    const int b = static_cast<int>(base);
+    for (const auto& e : Sub::instance())
+    {
+        const int parentId = e.parentId == e.id
+                                 ? static_cast<int>(ParentState::stateId)
+                                 : b + e.parentId;
+        m_data.addStateBase(b + e.id, parentId, e.size, e.maker, e.eventMask,
+                            &Mount::mount);
+    }
+}
+
+#endif /* SRC_STATECHART_SUBMACHINE_H_ */
@@ -63,6 +63,17 @@ class VecQueue
     {
         return m_store.empty();
     }
+    bool full() const
+    {
+        return false;
+    }
+
+    // Remove all elements, keeping the allocated capacity.
+    void clear()
+    {
+        m_store.clear();
+        m_headPos = 0;
+    }
 
   private:
     // Invariants:
@@ -0,0 +1,166 @@
+/*
+ * fsm_active_test.cpp
+ *
+ *  Test of active objects in the three execution contexts.
+ */
+
+#include "ActiveObject.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+class CountFsm;
+
+class CountFsmDesc
+{
+  public:
+    enum class StateId
+    {
+        counting,
+        stateIdNo
+    };
+
+    using Event = int;
+    using Fsm = CountFsm;
+
+    static void setupStates(FsmSetup<CountFsmDesc>& sc);
+};
+
+class CountFsm : public FsmBase<CountFsmDesc>
+{
+  public:
+    std::atomic<long> sum{0};
+    std::atomic<int> handled{0};
+    std::atomic<bool> inside{false};
+    bool overlap = false;
+    // Last event seen per producer, to check per producer FIFO order.
+    int last[8] = {-1, -1, -1, -1, -1, -1, -1, -1};
+    bool ordered = true;
+};
+
+class Counting : public StateBase<CountFsmDesc, CountFsmDesc::StateId::counting>
+{
+  public:
+    explicit Counting(StateArgs& args) : StateBase(args) {}
+
+    // Event is producer * 1000000 + sequence number.
+    bool event(int ev)
+    {
+        auto& f = fsm();
+        if (f.inside.exchange(true))
+            f.overlap = true;
+        const int producer = ev / 1000000;
+        const int seq = ev % 1000000;
+        if (seq <= f.last[producer])
+            f.ordered = false;
+        f.last[producer] = seq;
+        f.sum += seq;
+        f.inside = false;
+        f.handled++;
+        return true;
+    }
+};
+
+void
+CountFsmDesc::setupStates(FsmSetup<CountFsmDesc>& sc)
+{
+    sc.addState<Counting>();
+}
+
+const int perProducer = 20000;
+
+// Post from 'producers' threads through handles, retrying when full.
+void
+produce(active_handle<int> h, int producers)
+{
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p)
+        threads.emplace_back([h, p] {
+            for (int i = 0; i < perProducer; ++i)
+                while (!h.post(p * 1000000 + i))
+                    std::this_thread::yield();
+        });
+    for (auto& t : threads)
+        t.join();
+}
+
+template <class Ao>
+void
+waitFor(Ao& ao, int count)
+{
+    while (ao.fsm().handled.load() < count)
+        std::this_thread::yield();
+}
+
+int pends = 0;
+
+void
+pend(void*)
+{
+    pends++;
+}
+
+} // namespace
+
+TEST(ActiveObject, thread_context)
+{
+    active_object<CountFsm> ao;
+    ao.start(CountFsmDesc::StateId::counting);
+    produce(ao.handle(), 4);
+    waitFor(ao, 4 * perProducer);
+    EXPECT_EQ(ao.fsm().sum.load(), 4L * perProducer * (perProducer - 1) / 2);
+    EXPECT_TRUE(ao.fsm().ordered);
+    EXPECT_FALSE(ao.fsm().overlap);
+}
+
+TEST(ActiveObject, executor_context)
+{
+    ThreadPool pool(3);
+    using Ao = active_object<CountFsm, MpscQueue<int, 16>,
+                             ExecutorContext<ThreadPool>>;
+    Ao a(pool);
+    Ao b(pool);
+    a.start(CountFsmDesc::StateId::counting);
+    b.start(CountFsmDesc::StateId::counting);
+
+    std::thread other([&] { produce(b.handle(), 2); });
+    produce(a.handle(), 3);
+    other.join();
+    waitFor(a, 3 * perProducer);
+    waitFor(b, 2 * perProducer);
+    EXPECT_TRUE(a.fsm().ordered && b.fsm().ordered);
+    // Runs of one object never overlap on the pool threads.
+    EXPECT_FALSE(a.fsm().overlap || b.fsm().overlap);
+}
+
+TEST(ActiveObject, deferred_context)
+{
+    pends = 0;
+    active_object<CountFsm, MpscQueue<int, 4>, DeferredContext> ao(pend);
+    ao.start(CountFsmDesc::StateId::counting);
+
+    // Pend once until the deferred handler runs.
+    EXPECT_TRUE(ao.post(1));
+    EXPECT_TRUE(ao.post(2));
+    EXPECT_EQ(pends, 1);
+    EXPECT_EQ(ao.fsm().handled, 0);
+
+    EXPECT_TRUE(ao.post(3));
+    EXPECT_TRUE(ao.post(4));
+    EXPECT_FALSE(ao.post(5));
+
+    ao.context().runPending();
+    EXPECT_EQ(ao.fsm().handled, 4);
+    EXPECT_EQ(ao.fsm().sum, 10);
+
+    EXPECT_TRUE(ao.handle().post(5));
+    EXPECT_EQ(pends, 2);
+    ao.context().runPending();
+    EXPECT_EQ(ao.fsm().handled, 5);
+}
@@ -0,0 +1,50 @@
+/*
+ * fsm_alloc_hook.cpp
+ *
+ *  Global operator new counting allocations for FsmExplorer. Link into
+ *  test programs only.
+ */
+
+#include "FsmExplorer.h"
+
+#include <cstdlib>
+#include <new>
+
+void*
+operator new(std::size_t size)
+{
+    fsmAllocCounter().fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void*
+operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void
+operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete[](void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
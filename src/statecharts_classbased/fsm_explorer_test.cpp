@@ -0,0 +1,178 @@
+/*
+ * fsm_explorer_test.cpp
+ *
+ *  Test of the worst case run to completion explorer.
+ */
+
+#include "FsmExplorer.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <sstream>
+
+namespace
+{
+
+class ExFsm;
+
+class ExFsmDesc
+{
+  public:
+    enum class StateId
+    {
+        top,
+        idle,
+        busy,
+        slow,
+        unreachable,
+        stateIdNo
+    };
+
+    using Event = int;
+    using Fsm = ExFsm;
+
+    static void setupStates(FsmSetup<ExFsmDesc>& sc);
+};
+
+class ExFsm : public FsmBase<ExFsmDesc>
+{
+};
+
+using StateId = ExFsmDesc::StateId;
+
+enum
+{
+    next,
+    back,
+    work,
+};
+
+class Top : public StateBase<ExFsmDesc, StateId::top>
+{
+  public:
+    explicit Top(StateArgs& args) : StateBase(args) {}
+
+    bool event(int ev)
+    {
+        if (ev == back)
+            transition(StateId::idle);
+        return true;
+    }
+};
+
+class Idle : public StateBase<ExFsmDesc, StateId::idle>
+{
+  public:
+    explicit Idle(StateArgs& args) : StateBase(args) {}
+
+    bool event(int ev)
+    {
+        if (ev == next)
+            transition(StateId::busy);
+        return ev == next;
+    }
+};
+
+class Busy : public StateBase<ExFsmDesc, StateId::busy>
+{
+  public:
+    explicit Busy(StateArgs& args) : StateBase(args) {}
+
+    bool event(int ev)
+    {
+        if (ev == next)
+            transition(StateId::slow);
+        if (ev == work)
+            std::unique_ptr<int> p(new int(ev));
+        return ev != back;
+    }
+};
+
+class Slow : public StateBase<ExFsmDesc, StateId::slow>
+{
+  public:
+    explicit Slow(StateArgs& args) : StateBase(args) {}
+
+    bool event(int ev)
+    {
+        if (ev != work)
+            return false;
+        auto end = std::chrono::steady_clock::now() +
+                   std::chrono::microseconds(500);
+        while (std::chrono::steady_clock::now() < end)
+        {
+        }
+        return true;
+    }
+};
+
+class Unreachable : public StateBase<ExFsmDesc, StateId::unreachable>
+{
+  public:
+    explicit Unreachable(StateArgs& args) : StateBase(args) {}
+
+    bool event(int)
+    {
+        return false;
+    }
+};
+
+void
+ExFsmDesc::setupStates(FsmSetup<ExFsmDesc>& sc)
+{
+    sc.addState<Top>();
+    sc.addState<Idle, Top>();
+    sc.addState<Busy, Top>();
+    sc.addState<Slow, Top>();
+    sc.addState<Unreachable, Top>();
+}
+
+} // namespace
+
+TEST(FsmExplorer, explore)
+{
+    ExFsm fsm;
+    FsmExplorer<ExFsm> ex(fsm, StateId::idle, {next, back, work});
+    ex.exploreAll(3);
+
+    EXPECT_EQ(ex.reachable(), (std::vector<StateId>{
+                                  StateId::idle, StateId::busy,
+                                  StateId::slow}));
+
+    auto res = ex.results();
+    ASSERT_EQ(res.size(), 9u);
+    EXPECT_EQ(res[0].from, StateId::slow);
+    EXPECT_EQ(res[0].event, int(work));
+    EXPECT_EQ(res[0].path, (std::vector<int>{next, next}));
+    EXPECT_GE(res[0].ticks, 500000u);
+
+    auto allocs = ex.allocating();
+    ASSERT_EQ(allocs.size(), 1u);
+    EXPECT_EQ(allocs[0].from, StateId::busy);
+    EXPECT_EQ(allocs[0].event, int(work));
+    EXPECT_EQ(allocs[0].allocations, 1);
+
+    std::ostringstream os;
+    ex.report(os, 1);
+    EXPECT_NE(os.str().find("state 3 event 2 -> 3"), std::string::npos);
+    EXPECT_NE(os.str().find("allocating handlers:\nstate 2 event 2"),
+              std::string::npos);
+}
+
+TEST(FsmExplorer, random_walks)
+{
+    ExFsm fsm;
+    FsmExplorer<ExFsm> ex(fsm, StateId::idle, {next, back, work});
+    ex.randomWalks(20, 50, 1);
+
+    auto res = ex.results();
+    ASSERT_FALSE(res.empty());
+    EXPECT_EQ(res[0].from, StateId::slow);
+    // Path replays from the start state to the worst configuration.
+    fsm.reset(StateId::idle);
+    for (int ev : res[0].path)
+        fsm.postEvent(ev);
+    EXPECT_EQ(fsm.currentStateId(), StateId::slow);
+}
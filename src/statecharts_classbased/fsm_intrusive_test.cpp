@@ -0,0 +1,138 @@
+/*
+ * fsm_intrusive_test.cpp
+ *
+ *  Test of the intrusive event queue and event pool.
+ */
+
+#include "FsmExplorer.h"
+#include "IntrusiveQueue.h"
+#include "StateChart.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace
+{
+
+// Large event, passed through the FSM by link only.
+struct Packet : IntrusiveHook
+{
+    int id = 0;
+    bool reply = false;
+    char payload[1024];
+};
+
+class NetFsm;
+
+class NetFsmDesc
+{
+  public:
+    enum class StateId
+    {
+        up,
+        stateIdNo
+    };
+
+    using Event = Packet*;
+    using Queue = IntrusiveQueue<Packet>;
+    using Fsm = NetFsm;
+
+    static void setupStates(FsmSetup<NetFsmDesc>& sc);
+};
+
+class NetFsm : public FsmBase<NetFsmDesc>
+{
+  public:
+    EventPool<Packet, 4> pool;
+    std::vector<int> seen;
+    std::vector<const Packet*> addresses;
+};
+
+class Up : public StateBase<NetFsmDesc, NetFsmDesc::StateId::up>
+{
+  public:
+    explicit Up(StateArgs& args) : StateBase(args) {}
+
+    bool event(Packet* p)
+    {
+        auto& f = fsm();
+        f.seen.push_back(p->id);
+        f.addresses.push_back(p);
+        // Queue a reply, delivered after this packet is released.
+        if (p->reply)
+        {
+            Packet* r = f.pool.acquire();
+            r->id = p->id + 100;
+            r->reply = false;
+            f.postEvent(r);
+        }
+        return true;
+    }
+};
+
+void
+NetFsmDesc::setupStates(FsmSetup<NetFsmDesc>& sc)
+{
+    sc.addState<Up>();
+}
+
+} // namespace
+
+TEST(IntrusiveQueue, fifo_and_release)
+{
+    EventPool<Packet, 3> pool;
+    IntrusiveQueue<Packet> q;
+    EXPECT_TRUE(q.empty());
+    Packet* a = pool.acquire();
+    Packet* b = pool.acquire();
+    Packet external;
+    q.push(a);
+    q.push(&external);
+    q.push(b);
+    EXPECT_EQ(pool.available(), 1u);
+    EXPECT_EQ(q.front(), a);
+    q.pop();
+    EXPECT_EQ(pool.available(), 2u);
+    EXPECT_EQ(q.front(), &external);
+    q.pop();
+    // Not from a pool, nothing to release.
+    EXPECT_EQ(pool.available(), 2u);
+    q.push(a = pool.acquire());
+    q.clear();
+    EXPECT_TRUE(q.empty());
+    EXPECT_EQ(pool.available(), 3u);
+}
+
+TEST(StateChart, intrusive_queue)
+{
+    NetFsm fsm;
+    fsm.setStartState(NetFsmDesc::StateId::up);
+    fsm.seen.reserve(200);
+    fsm.addresses.reserve(200);
+
+    const long allocs = fsmAllocCounter().load();
+    for (int i = 0; i < 100; ++i)
+    {
+        Packet* p = fsm.pool.acquire();
+        ASSERT_NE(p, nullptr);
+        p->id = i;
+        p->reply = i % 10 == 0;
+        fsm.postEvent(p);
+        // Packets go back to the pool after dispatch.
+        EXPECT_EQ(fsm.pool.available(), 4u);
+    }
+    // No queue storage is allocated.
+    EXPECT_EQ(fsmAllocCounter().load() - allocs, 0);
+
+    ASSERT_EQ(fsm.seen.size(), 110u);
+    EXPECT_EQ(fsm.seen[0], 0);
+    EXPECT_EQ(fsm.seen[1], 100);
+    EXPECT_EQ(fsm.seen[2], 1);
+    // Events are the pool objects themselves, never copies.
+    for (const Packet* p : fsm.addresses)
+    {
+        EXPECT_GE(p, reinterpret_cast<const Packet*>(&fsm.pool));
+        EXPECT_LT(p, reinterpret_cast<const Packet*>(&fsm.pool + 1));
+    }
+}
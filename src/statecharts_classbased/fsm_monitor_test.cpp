@@ -0,0 +1,180 @@
+/*
+ * fsm_monitor_test.cpp
+ *
+ *  Test of state publication to monitoring threads.
+ */
+
+#include "FsmMonitor.h"
+#include "StateChart.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+namespace
+{
+
+class MonFsm;
+
+class MonFsmDesc
+{
+  public:
+    enum class StateId
+    {
+        ping,
+        pong,
+        stateIdNo
+    };
+
+    using Event = int;
+    using Fsm = MonFsm;
+
+    static void setupStates(FsmSetup<MonFsmDesc>& sc);
+};
+
+class MonFsm : public FsmBase<MonFsmDesc>
+{
+};
+
+using StateId = MonFsmDesc::StateId;
+
+// Ticks once per call, to make timestamps predictable.
+struct CountingClock
+{
+    static uint64_t now()
+    {
+        return ++ticks;
+    }
+    static uint64_t ticks;
+};
+
+uint64_t CountingClock::ticks = 0;
+
+class Ping : public StateBase<MonFsmDesc, StateId::ping>
+{
+  public:
+    explicit Ping(StateArgs& args) : StateBase(args) {}
+
+    bool event(int)
+    {
+        transition(StateId::pong);
+        return true;
+    }
+};
+
+class Pong : public StateBase<MonFsmDesc, StateId::pong>
+{
+  public:
+    explicit Pong(StateArgs& args) : StateBase(args) {}
+
+    bool event(int)
+    {
+        transition(StateId::ping);
+        return true;
+    }
+};
+
+void
+MonFsmDesc::setupStates(FsmSetup<MonFsmDesc>& sc)
+{
+    sc.addState<Ping>();
+    sc.addState<Pong>();
+}
+
+} // namespace
+
+TEST(FsmMonitor, publish)
+{
+    FsmStateSlot<CountingClock> slot;
+    EXPECT_EQ(slot.stateId(), -1);
+    {
+        MonFsm fsm;
+        fsm.publishTo(&slot);
+        EXPECT_EQ(slot.snapshot().sequence, 1u);
+
+        fsm.setStartState(StateId::ping);
+        EXPECT_EQ(slot.stateId(), int(StateId::ping));
+
+        fsm.postEvent(0);
+        FsmSnapshot s = slot.snapshot();
+        EXPECT_EQ(s.stateId, int(StateId::pong));
+        EXPECT_EQ(s.sequence, 3u);
+        EXPECT_EQ(s.transitions, 1u);
+        EXPECT_EQ(s.timestamp, CountingClock::ticks);
+    }
+    // Stopping the FSM publishes the null state.
+    EXPECT_EQ(slot.stateId(), -1);
+    EXPECT_EQ(slot.snapshot().sequence, 4u);
+    EXPECT_EQ(slot.snapshot().transitions, 1u);
+}
+
+TEST(FsmMonitor, transitions_not_counted_on_attach_stop_start)
+{
+    FsmStateSlot<CountingClock> slot;
+    MonFsm fsm;
+    fsm.publishTo(&slot);
+    EXPECT_EQ(slot.snapshot().transitions, 0u);
+
+    fsm.setStartState(StateId::ping);
+    fsm.postEvent(0);
+    fsm.postEvent(0);
+    EXPECT_EQ(slot.snapshot().transitions, 2u);
+
+    fsm.stop();
+    fsm.setStartState(StateId::ping);
+    fsm.publishTo(&slot);
+    FsmSnapshot s = slot.snapshot();
+    EXPECT_EQ(s.stateId, int(StateId::ping));
+    EXPECT_EQ(s.transitions, 2u);
+    EXPECT_EQ(s.sequence, 7u);
+    EXPECT_EQ(fsm.transitionCount(), 2u);
+}
+
+TEST(FsmMonitor, export_and_concurrent_read)
+{
+    const int fsmNo = 64;
+    FsmStateSlot<> slots[fsmNo];
+    MonFsm fsms[fsmNo];
+    for (int i = 0; i < fsmNo; ++i)
+    {
+        fsms[i].publishTo(&slots[i]);
+        fsms[i].setStartState(StateId::ping);
+    }
+
+    std::atomic<bool> done{false};
+    bool consistent = true;
+    std::thread monitor([&] {
+        FsmSnapshot out[fsmNo];
+        uint32_t last[fsmNo] = {};
+        while (!done.load())
+        {
+            exportSnapshots(slots, fsmNo, out);
+            for (int i = 0; i < fsmNo; ++i)
+            {
+                // Even sequence numbers (after start) are always in ping.
+                const bool ping = out[i].sequence % 2 == 0;
+                if (out[i].sequence < last[i] ||
+                    (out[i].stateId == int(StateId::ping)) != ping)
+                    consistent = false;
+                last[i] = out[i].sequence;
+            }
+        }
+    });
+
+    for (int round = 0; round < 2000; ++round)
+        for (auto& fsm : fsms)
+            fsm.postEvent(0);
+    done = true;
+    monitor.join();
+    EXPECT_TRUE(consistent);
+
+    FsmSnapshot out[fsmNo];
+    exportSnapshots(slots, fsmNo, out);
+    // publishTo, start and 2000 transitions.
+    EXPECT_EQ(out[0].sequence, 2002u);
+    EXPECT_EQ(out[fsmNo - 1].stateId, int(StateId::ping));
+
+    for (auto& fsm : fsms)
+        fsm.publishTo<FsmStateSlot<>>(nullptr);
+}
@@ -0,0 +1,206 @@
+/*
+ * fsm_pool_test.cpp
+ *
+ *  Test of FSM reset and the FSM instance pool.
+ */
+
+#include "FsmPool.h"
+#include "StateChart.h"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+
+namespace
+{
+
+class SessionFsm;
+
+class SessionFsmDesc
+{
+  public:
+    enum class StateId
+    {
+        session,
+        idle,
+        active,
+        stateIdNo
+    };
+
+    using Event = int;
+    using Fsm = SessionFsm;
+
+    static void setupStates(FsmSetup<SessionFsmDesc>& sc);
+};
+
+class SessionFsm : public FsmBase<SessionFsmDesc>
+{
+  public:
+    int entries = 0;
+    int exits = 0;
+    int events = 0;
+};
+
+using StateId = SessionFsmDesc::StateId;
+
+template <StateId id>
+class SessionState : public StateBase<SessionFsmDesc, id>
+{
+  public:
+    explicit SessionState(StateArgs& args)
+        : StateBase<SessionFsmDesc, id>(args)
+    {
+        this->fsm().entries++;
+    }
+
+    ~SessionState()
+    {
+        this->fsm().exits++;
+    }
+};
+
+class Session : public SessionState<StateId::session>
+{
+  public:
+    explicit Session(StateArgs& args) : SessionState(args) {}
+
+    bool event(int)
+    {
+        return true;
+    }
+};
+
+class Idle : public SessionState<StateId::idle>
+{
+  public:
+    explicit Idle(StateArgs& args) : SessionState(args) {}
+
+    bool event(int ev)
+    {
+        fsm().events++;
+        // Queue more events, to be dropped by a reset.
+        if (ev == 1)
+            for (int i = 0; i < 4; ++i)
+                fsm().addEvent(0);
+        transition(StateId::active);
+        return true;
+    }
+};
+
+class Active : public SessionState<StateId::active>
+{
+  public:
+    explicit Active(StateArgs& args) : SessionState(args) {}
+
+    bool event(int ev)
+    {
+        fsm().events++;
+        // Stop from within the handler, done once it returns.
+        if (ev == 2)
+            fsm().stop();
+        return false;
+    }
+};
+
+void
+SessionFsmDesc::setupStates(FsmSetup<SessionFsmDesc>& sc)
+{
+    sc.addState<Session>();
+    sc.addState<Idle, Session>();
+    sc.addState<Active, Session>();
+}
+
+} // namespace
+
+TEST(StateChart, reset)
+{
+    SessionFsm fsm;
+    fsm.setStartState(StateId::idle);
+    auto size = fsm.storageSize();
+    fsm.postEvent(0);
+    EXPECT_EQ(fsm.currentStateId(), StateId::active);
+    EXPECT_EQ(fsm.entries, 3);
+
+    fsm.reset(StateId::idle);
+    EXPECT_EQ(fsm.currentStateId(), StateId::idle);
+    EXPECT_EQ(fsm.exits, 3);
+    EXPECT_EQ(fsm.entries, 5);
+    EXPECT_EQ(fsm.storageSize(), size);
+
+    fsm.stop();
+    EXPECT_EQ(fsm.currentStateId(), SessionFsm::nullStateId());
+    EXPECT_EQ(fsm.exits, 5);
+}
+
+TEST(StateChart, stop_drops_queued_events)
+{
+    SessionFsm fsm;
+    fsm.setStartState(StateId::idle);
+    fsm.addEvent(1);
+    fsm.addEvent(0);
+    fsm.stop();
+    fsm.setStartState(StateId::idle);
+    fsm.processQueue();
+    EXPECT_EQ(fsm.events, 0);
+    EXPECT_EQ(fsm.currentStateId(), StateId::idle);
+}
+
+TEST(StateChart, stop_from_event_handler)
+{
+    SessionFsm fsm;
+    fsm.setStartState(StateId::idle);
+    fsm.addEvent(0);
+    fsm.addEvent(2);
+    fsm.addEvent(0);
+    fsm.processQueue();
+    EXPECT_EQ(fsm.currentStateId(), SessionFsm::nullStateId());
+    EXPECT_EQ(fsm.events, 2);
+    EXPECT_EQ(fsm.exits, 3);
+
+    // Usable again afterwards.
+    fsm.setStartState(StateId::idle);
+    fsm.postEvent(0);
+    EXPECT_EQ(fsm.currentStateId(), StateId::active);
+}
+
+TEST(FsmPool, acquire_release)
+{
+    FsmPool<SessionFsm, 2> pool;
+    EXPECT_EQ(pool.available(), 2u);
+
+    SessionFsm* a = pool.acquire(StateId::idle);
+    SessionFsm* b = pool.acquire(StateId::active);
+    ASSERT_TRUE(a && b);
+    EXPECT_NE(a, b);
+    EXPECT_EQ(pool.acquire(StateId::idle), nullptr);
+    EXPECT_EQ(b->currentStateId(), StateId::active);
+
+    a->postEvent(0);
+    auto size = a->storageSize();
+    pool.release(a);
+    EXPECT_EQ(a->currentStateId(), SessionFsm::nullStateId());
+    EXPECT_EQ(pool.available(), 1u);
+
+    // Most recently released instance is reused, storage and all.
+    SessionFsm* c = pool.acquire(StateId::idle);
+    EXPECT_EQ(c, a);
+    EXPECT_EQ(c->storageSize(), size);
+    EXPECT_EQ(c->currentStateId(), StateId::idle);
+
+    pool.release(b);
+    pool.release(c);
+    EXPECT_EQ(pool.available(), 2u);
+}
+
+TEST(FsmPool, bad_release)
+{
+    FsmPool<SessionFsm, 2> pool;
+    SessionFsm* a = pool.acquire(StateId::idle);
+    pool.release(a);
+    EXPECT_THROW(pool.release(a), std::runtime_error);
+    EXPECT_EQ(pool.available(), 2u);
+
+    SessionFsm other;
+    EXPECT_THROW(pool.release(&other), std::runtime_error);
+    EXPECT_EQ(pool.available(), 2u);
+}
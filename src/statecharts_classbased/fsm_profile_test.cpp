@@ -0,0 +1,184 @@
+/*
+ * fsm_profile_test.cpp
+ *
+ *  Test of transition and event counters. Built with STATECHART_PROFILE.
+ */
+
+#include "StateChart.h"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+namespace
+{
+
+enum class Cmd
+{
+    open,
+    data,
+    close,
+    cmdNo
+};
+
+struct CmdEvent
+{
+    Cmd cmd;
+};
+
+} // namespace
+
+// Give each command its own id in the profile.
+template <>
+struct FsmEventTraits<CmdEvent> : FsmEventTraitsBase<CmdEvent>
+{
+    enum
+    {
+        idNo = static_cast<int>(Cmd::cmdNo)
+    };
+
+    static int id(const CmdEvent& ev)
+    {
+        return static_cast<int>(ev.cmd);
+    }
+};
+
+namespace
+{
+
+class ProfFsm;
+
+class ProfFsmDesc
+{
+  public:
+    enum class StateId
+    {
+        top,
+        closed,
+        opened,
+        stateIdNo
+    };
+
+    using Event = CmdEvent;
+    using Fsm = ProfFsm;
+
+    static void setupStates(FsmSetup<ProfFsmDesc>& sc);
+};
+
+class ProfFsm : public FsmBase<ProfFsmDesc>
+{
+};
+
+using StateId = ProfFsmDesc::StateId;
+
+class Top : public StateBase<ProfFsmDesc, StateId::top>
+{
+  public:
+    explicit Top(StateArgs& args) : StateBase(args) {}
+
+    bool event(const CmdEvent&)
+    {
+        return true;
+    }
+};
+
+class Closed : public StateBase<ProfFsmDesc, StateId::closed>
+{
+  public:
+    explicit Closed(StateArgs& args) : StateBase(args) {}
+
+    bool event(const CmdEvent& ev)
+    {
+        if (ev.cmd != Cmd::open)
+            return false;
+        transition(StateId::opened);
+        return true;
+    }
+};
+
+class Opened : public StateBase<ProfFsmDesc, StateId::opened>
+{
+  public:
+    explicit Opened(StateArgs& args) : StateBase(args) {}
+
+    bool event(const CmdEvent& ev)
+    {
+        if (ev.cmd == Cmd::close)
+            transition(StateId::closed);
+        return true;
+    }
+};
+
+void
+ProfFsmDesc::setupStates(FsmSetup<ProfFsmDesc>& sc)
+{
+    sc.addState<Top>();
+    sc.addState<Closed, Top>();
+    sc.addState<Opened, Top>();
+}
+
+int
+id(StateId s)
+{
+    return static_cast<int>(s);
+}
+
+int
+id(Cmd c)
+{
+    return static_cast<int>(c);
+}
+
+} // namespace
+
+TEST(FsmProfile, counters)
+{
+    const FsmProfileData& p = ProfFsm::profile();
+    p.reset();
+    {
+        ProfFsm a;
+        ProfFsm b;
+        a.setStartState(StateId::closed);
+        b.setStartState(StateId::closed);
+        for (int i = 0; i < 3; ++i)
+        {
+            a.postEvent({Cmd::open});
+            a.postEvent({Cmd::data});
+            a.postEvent({Cmd::data});
+            a.postEvent({Cmd::close});
+        }
+        b.postEvent({Cmd::data});
+    }
+
+    EXPECT_EQ(p.stateNo(), 3);
+    EXPECT_EQ(p.eventIdNo(), 3);
+
+    // Counters are shared by all FSMs of the type.
+    EXPECT_EQ(p.transitionCount(-1, id(StateId::closed)), 2u);
+    EXPECT_EQ(p.transitionCount(id(StateId::closed), id(StateId::opened)),
+              3u);
+    EXPECT_EQ(p.transitionCount(id(StateId::opened), id(StateId::closed)),
+              3u);
+
+    EXPECT_EQ(p.eventCount(id(StateId::opened), id(Cmd::data)), 6u);
+    EXPECT_EQ(p.eventCount(id(StateId::closed), id(Cmd::open)), 3u);
+    // Not handled in closed, passed on to top.
+    EXPECT_EQ(p.eventCount(id(StateId::closed), id(Cmd::data)), 1u);
+    EXPECT_EQ(p.eventCount(id(StateId::top), id(Cmd::data)), 1u);
+    EXPECT_EQ(p.eventCount(id(StateId::top), id(Cmd::open)), 0u);
+
+    std::ostringstream os;
+    writeProfile(os, p);
+    EXPECT_NE(os.str().find("transition -1 1 2\n"), std::string::npos);
+    EXPECT_NE(os.str().find("event 2 1 6\n"), std::string::npos);
+
+    p.reset();
+    EXPECT_EQ(p.eventCount(id(StateId::opened), id(Cmd::data)), 0u);
+}
+
+int
+main(int ac, char* av[])
+{
+    testing::InitGoogleTest(&ac, av);
+    return RUN_ALL_TESTS();
+}
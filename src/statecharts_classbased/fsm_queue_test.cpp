@@ -0,0 +1,167 @@
+/*
+ * fsm_queue_test.cpp
+ *
+ *  Test of the fixed capacity event queue and error handling.
+ */
+
+#include "StateChart.h"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+
+namespace
+{
+
+class QueueFsm;
+
+class QueueFsmDesc
+{
+  public:
+    enum class StateId
+    {
+        root,
+        child,
+        stateIdNo
+    };
+
+    using Event = int;
+
+    // Select a fixed size queue instead of the default VecQueue.
+    using Queue = FixedQueue<Event, 2>;
+
+    using Fsm = QueueFsm;
+
+    static void setupStates(FsmSetup<QueueFsmDesc>& sc);
+};
+
+class QueueFsm : public FsmBase<QueueFsmDesc>
+{
+  public:
+    int events = 0;
+};
+
+using StateId = QueueFsmDesc::StateId;
+
+class Child;
+
+class Root : public StateBase<QueueFsmDesc, StateId::root>
+{
+  public:
+    explicit Root(StateArgs& args) : StateBase(args) {}
+
+    bool event(int ev)
+    {
+        fsm().events++;
+        // Post more events than fit in the queue.
+        if (ev == 1)
+            for (int i = 0; i < 3; ++i)
+                fsm().addEvent(0);
+        // Error, root has no parent.
+        if (ev == 2)
+            parent<Child>();
+        return true;
+    }
+};
+
+class Child : public StateBase<QueueFsmDesc, StateId::child>
+{
+  public:
+    explicit Child(StateArgs& args) : StateBase(args) {}
+
+    bool event(int)
+    {
+        return false;
+    }
+};
+
+void
+QueueFsmDesc::setupStates(FsmSetup<QueueFsmDesc>& sc)
+{
+    sc.addState<Root>();
+    sc.addState<Child, Root>();
+}
+
+FsmError lastError;
+int errorCount = 0;
+
+void
+countingHandler(FsmError e)
+{
+    lastError = e;
+    errorCount++;
+}
+
+void
+throwingHandler(FsmError e)
+{
+    throw std::logic_error(toString(e));
+}
+
+} // namespace
+
+TEST(FixedQueue, ring)
+{
+    FixedQueue<std::string, 3> q;
+    EXPECT_TRUE(q.empty());
+    for (int round = 0; round < 4; ++round)
+    {
+        q.push("a");
+        q.push("b");
+        q.push("c");
+        EXPECT_TRUE(q.full());
+        EXPECT_EQ(q.front(), "a");
+        q.pop();
+        q.push("d");
+        EXPECT_EQ(q.size(), 3u);
+        q.pop();
+        q.pop();
+        EXPECT_EQ(q.front(), "d");
+        q.pop();
+        EXPECT_TRUE(q.empty());
+    }
+    q.push("left in queue");
+}
+
+TEST(StateChart, fixed_queue_full)
+{
+    auto old = setFsmErrorHandler(countingHandler);
+    errorCount = 0;
+    {
+        QueueFsm fsm;
+        fsm.setStartState(StateId::child);
+        EXPECT_GT(fsm.storageSize(), 0u);
+
+        // Queue holds the event being processed plus one more.
+        fsm.postEvent(1);
+        EXPECT_EQ(errorCount, 2);
+        EXPECT_EQ(lastError, FsmError::queueFull);
+        EXPECT_EQ(fsm.events, 2);
+    }
+    setFsmErrorHandler(old);
+}
+
+TEST(StateChart, error_handler)
+{
+    QueueFsm fsm;
+    fsm.setStartState(StateId::root);
+
+    // Default handler throws when exceptions are enabled.
+    EXPECT_THROW(fsm.postEvent(2), std::runtime_error);
+
+    auto old = setFsmErrorHandler(throwingHandler);
+    QueueFsm fsm2;
+    fsm2.setStartState(StateId::root);
+    EXPECT_THROW(fsm2.postEvent(2), std::logic_error);
+    setFsmErrorHandler(old);
+}
+
+TEST(StateChart, restart_reuses_storage)
+{
+    QueueFsm fsm;
+    fsm.setStartState(StateId::child);
+    auto size = fsm.storageSize();
+    fsm.setStartState(StateId::root);
+    EXPECT_EQ(fsm.currentStateId(), StateId::root);
+    EXPECT_EQ(fsm.storageSize(), size);
+}
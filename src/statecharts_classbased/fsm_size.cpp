@@ -0,0 +1,114 @@
+/*
+ * fsm_size.cpp
+ *
+ *  Size report for a small FSM in the freestanding configuration. Built
+ *  by 'make size' without exceptions, RTTI or iostream. Flash cost is
+ *  given by 'size' on the object files, RAM cost is printed when run.
+ */
+
+#include "StateChart.h"
+
+#include <cstdio>
+
+namespace
+{
+
+class SizeFsm;
+
+class SizeFsmDesc
+{
+  public:
+    enum class StateId
+    {
+        off,
+        on,
+        blinking,
+        stateIdNo
+    };
+
+    enum class Event
+    {
+        toggle,
+        blink,
+    };
+
+    using Queue = FixedQueue<Event, 4>;
+
+    using Fsm = SizeFsm;
+
+    static void setupStates(FsmSetup<SizeFsmDesc>& sc);
+};
+
+class SizeFsm : public FsmBase<SizeFsmDesc>
+{
+};
+
+using StateId = SizeFsmDesc::StateId;
+using Event = SizeFsmDesc::Event;
+
+class Off : public StateBase<SizeFsmDesc, StateId::off>
+{
+  public:
+    explicit Off(StateArgs& args) : StateBase(args) {}
+
+    bool event(Event ev)
+    {
+        if (ev == Event::toggle)
+            transition(StateId::on);
+        return true;
+    }
+};
+
+class On : public StateBase<SizeFsmDesc, StateId::on>
+{
+  public:
+    explicit On(StateArgs& args) : StateBase(args) {}
+
+    bool event(Event ev)
+    {
+        if (ev == Event::toggle)
+            transition(StateId::off);
+        if (ev == Event::blink)
+            transition(StateId::blinking);
+        return true;
+    }
+};
+
+class Blinking : public StateBase<SizeFsmDesc, StateId::blinking>
+{
+  public:
+    explicit Blinking(StateArgs& args) : StateBase(args) {}
+
+    bool event(Event ev)
+    {
+        return ev == Event::blink;
+    }
+
+    int phase = 0;
+};
+
+void
+SizeFsmDesc::setupStates(FsmSetup<SizeFsmDesc>& sc)
+{
+    sc.addState<Off>();
+    sc.addState<On>();
+    sc.addState<Blinking, On>();
+}
+
+} // namespace
+
+int
+main()
+{
+    SizeFsm fsm;
+    fsm.setStartState(StateId::off);
+    fsm.postEvent(Event::toggle);
+    fsm.postEvent(Event::blink);
+    fsm.postEvent(Event::toggle);
+
+    std::printf("sizeof(Fsm)              : %zu\n", sizeof(SizeFsm));
+    std::printf("state storage (heap)     : %zu\n", fsm.storageSize());
+    std::printf("static setup data        : %zu\n",
+                sizeof(FsmSetup<SizeFsmDesc>));
+    return fsm.currentStateId() == StateId::off ? 0 : 1;
+}
@@ -0,0 +1,300 @@
+/*
+ * fsm_submachine_test.cpp
+ *
+ *  Test of a submachine mounted in two FSM types and at two places.
+ */
+
+#include "Submachine.h"
+
+#include <gtest/gtest.h>
+
+namespace
+{
+
+enum class Ev
+{
+    ok,
+    fail,
+    timeout,
+    poke,
+};
+
+// Data the retry submachine needs from the FSM.
+struct RetryContext
+{
+    int maxAttempts = 2;
+    int attempts = 0;
+    int backoffs = 0;
+};
+
+// Retry with backoff. 'retrying' is the submachine root, 'waiting' and
+// 'backoff' are its children.
+class RetryDesc
+{
+  public:
+    enum class StateId
+    {
+        retrying,
+        waiting,
+        backoff,
+        stateIdNo
+    };
+
+    enum class ExitId
+    {
+        done,
+        failed,
+        exitIdNo
+    };
+
+    using Event = Ev;
+    using Context = RetryContext;
+
+    static void setupStates(SubSetup<RetryDesc>& sc);
+};
+
+using RetryId = RetryDesc::StateId;
+
+class Retrying : public SubStateBase<RetryDesc, RetryId::retrying>
+{
+  public:
+    explicit Retrying(const StateArgs& args) : SubStateBase(args)
+    {
+        context().attempts = 0;
+    }
+
+    bool event(Ev ev)
+    {
+        if (ev == Ev::ok)
+        {
+            leave(ExitId::done);
+            return true;
+        }
+        return false;
+    }
+};
+
+class Waiting : public SubStateBase<RetryDesc, RetryId::waiting>
+{
+  public:
+    explicit Waiting(const StateArgs& args) : SubStateBase(args) {}
+
+    bool event(Ev ev)
+    {
+        if (ev != Ev::fail)
+            return false;
+        // Reach the submachine parent, mounted at different ids.
+        parent<Retrying>();
+        if (++context().attempts >= context().maxAttempts)
+            leave(ExitId::failed);
+        else
+            transition(RetryId::backoff);
+        return true;
+    }
+};
+
+class Backoff : public SubStateBase<RetryDesc, RetryId::backoff>
+{
+  public:
+    explicit Backoff(const StateArgs& args) : SubStateBase(args)
+    {
+        context().backoffs++;
+    }
+
+    bool event(Ev ev)
+    {
+        if (ev == Ev::timeout)
+            transition<Waiting>();
+        return ev == Ev::timeout;
+    }
+};
+
+void
+RetryDesc::setupStates(SubSetup<RetryDesc>& sc)
+{
+    sc.addState<Retrying>();
+    sc.addState<Waiting, Retrying>();
+    sc.addState<Backoff, Retrying>();
+}
+
+const int retryNo = static_cast<int>(RetryId::stateIdNo);
+
+// First FSM, one mount point.
+class LinkFsm;
+
+class LinkDesc
+{
+  public:
+    enum class StateId
+    {
+        top,
+        retry,
+        retryLast = retry + retryNo - 1,
+        online,
+        offline,
+        stateIdNo
+    };
+
+    using Event = Ev;
+    using Fsm = LinkFsm;
+
+    static void setupStates(FsmSetup<LinkDesc>& sc);
+};
+
+class LinkFsm : public FsmBase<LinkDesc>, public RetryContext
+{
+  public:
+    int pokes = 0;
+};
+
+using LinkId = LinkDesc::StateId;
+
+class LinkTop : public StateBase<LinkDesc, LinkId::top>
+{
+  public:
+    explicit LinkTop(StateArgs& args) : StateBase(args) {}
+
+    bool event(Ev ev)
+    {
+        if (ev == Ev::poke)
+            fsm().pokes++;
+        return true;
+    }
+};
+
+template <LinkId id>
+class LinkLeaf : public StateBase<LinkDesc, id>
+{
+  public:
+    explicit LinkLeaf(StateArgs& args) : StateBase<LinkDesc, id>(args) {}
+
+    bool event(Ev)
+    {
+        return false;
+    }
+};
+
+void
+LinkDesc::setupStates(FsmSetup<LinkDesc>& sc)
+{
+    sc.addState<LinkTop>();
+    sc.addSubmachine<RetryDesc, LinkTop, LinkId::retry, LinkId::online,
+                     LinkId::offline>();
+    sc.addState<LinkLeaf<LinkId::online>, LinkTop>();
+    sc.addState<LinkLeaf<LinkId::offline>, LinkTop>();
+}
+
+// Second FSM type, the same submachine mounted twice under one parent.
+class TwoFsm;
+
+class TwoDesc
+{
+  public:
+    enum class StateId
+    {
+        first,
+        firstLast = first + retryNo - 1,
+        middle,
+        second,
+        secondLast = second + retryNo - 1,
+        end,
+        stateIdNo
+    };
+
+    using Event = Ev;
+    using Fsm = TwoFsm;
+
+    static void setupStates(FsmSetup<TwoDesc>& sc);
+};
+
+class TwoFsm : public FsmBase<TwoDesc>, public RetryContext
+{
+};
+
+using TwoId = TwoDesc::StateId;
+
+template <TwoId id>
+class TwoState : public StateBase<TwoDesc, id>
+{
+  public:
+    explicit TwoState(StateArgs& args) : StateBase<TwoDesc, id>(args) {}
+
+    bool event(Ev)
+    {
+        return true;
+    }
+};
+
+void
+TwoDesc::setupStates(FsmSetup<TwoDesc>& sc)
+{
+    sc.addState<TwoState<TwoId::middle>>();
+    sc.addState<TwoState<TwoId::end>>();
+    sc.addSubmachine<RetryDesc, TwoState<TwoId::middle>, TwoId::first,
+                     TwoId::end, TwoId::second>();
+    sc.addSubmachine<RetryDesc, TwoState<TwoId::middle>, TwoId::second,
+                     TwoId::end, TwoId::end>();
+}
+
+LinkId
+linkId(RetryId id)
+{
+    return static_cast<LinkId>(static_cast<int>(LinkId::retry) +
+                               static_cast<int>(id));
+}
+
+TwoId
+twoId(TwoId base, RetryId id)
+{
+    return static_cast<TwoId>(static_cast<int>(base) + static_cast<int>(id));
+}
+
+} // namespace
+
+TEST(Submachine, retry_until_failed)
+{
+    LinkFsm fsm;
+    fsm.setStartState(linkId(RetryId::waiting));
+    EXPECT_EQ(fsm.currentStateId(), linkId(RetryId::waiting));
+
+    // Events not handled by the submachine reach the FSM parent.
+    fsm.postEvent(Ev::poke);
+    EXPECT_EQ(fsm.pokes, 1);
+
+    fsm.postEvent(Ev::fail);
+    EXPECT_EQ(fsm.currentStateId(), linkId(RetryId::backoff));
+    EXPECT_EQ(fsm.backoffs, 1);
+    fsm.postEvent(Ev::timeout);
+    EXPECT_EQ(fsm.currentStateId(), linkId(RetryId::waiting));
+    fsm.postEvent(Ev::fail);
+    EXPECT_EQ(fsm.currentStateId(), LinkId::offline);
+    EXPECT_EQ(fsm.attempts, 2);
+}
+
+TEST(Submachine, retry_done)
+{
+    LinkFsm fsm;
+    fsm.setStartState(linkId(RetryId::waiting));
+    fsm.postEvent(Ev::fail);
+    // Handled by the submachine root from a child.
+    fsm.postEvent(Ev::ok);
+    EXPECT_EQ(fsm.currentStateId(), LinkId::online);
+}
+
+TEST(Submachine, two_mount_points)
+{
+    TwoFsm fsm;
+    fsm.maxAttempts = 1;
+    fsm.setStartState(twoId(TwoId::first, RetryId::waiting));
+
+    // First mount fails over to the second mount, entering its root.
+    fsm.postEvent(Ev::fail);
+    EXPECT_EQ(fsm.currentStateId(), TwoId::second);
+    EXPECT_EQ(fsm.attempts, 0);
+
+    fsm.reset(twoId(TwoId::second, RetryId::backoff));
+    fsm.postEvent(Ev::timeout);
+    EXPECT_EQ(fsm.currentStateId(), twoId(TwoId::second, RetryId::waiting));
+    fsm.postEvent(Ev::ok);
+    EXPECT_EQ(fsm.currentStateId(), TwoId::end);
+}
@@ -0,0 +1,181 @@
+/*
+ * fsm_variant_test.cpp
+ *
+ *  Test of an FSM using a std::variant of message types as Event.
+ *  Requires C++17.
+ */
+
+#include "StateChart.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <variant>
+
+namespace
+{
+
+// Message types. Each can carry its own payload.
+struct Tick
+{
+    int ms;
+};
+
+struct Data
+{
+    std::string payload;
+};
+
+struct Stop
+{
+};
+
+class VarFsm;
+
+class VarFsmDesc
+{
+  public:
+    enum class StateId
+    {
+        top,
+        idle,
+        receiving,
+        stateIdNo
+    };
+
+    // The event is a variant. It is queued by value, no heap boxing of
+    // the individual message types is needed.
+    using Event = std::variant<Tick, Data, Stop>;
+
+    using Fsm = VarFsm;
+
+    static void setupStates(FsmSetup<VarFsmDesc>& sc);
+};
+
+class VarFsm : public FsmBase<VarFsmDesc>
+{
+  public:
+    int topCalls = 0;
+    int idleCalls = 0;
+    int receivingCalls = 0;
+    int totalMs = 0;
+    std::string received;
+};
+
+using StateId = VarFsmDesc::StateId;
+
+class Receiving;
+
+// Top level state. Takes the whole variant as a catch all.
+class Top : public StateBase<VarFsmDesc, StateId::top>
+{
+  public:
+    explicit Top(StateArgs& args) : StateBase(args) {}
+
+    bool event(const VarFsmDesc::Event&)
+    {
+        fsm().topCalls++;
+        return true;
+    }
+};
+
+// Only handles Tick and Data. Stop is never delivered here.
+class Idle : public StateBase<VarFsmDesc, StateId::idle>
+{
+  public:
+    explicit Idle(StateArgs& args) : StateBase(args) {}
+
+    bool event(const Tick& t)
+    {
+        fsm().idleCalls++;
+        fsm().totalMs += t.ms;
+        return true;
+    }
+
+    bool event(const Data& d)
+    {
+        fsm().idleCalls++;
+        fsm().received = d.payload;
+        transition<Receiving>();
+        return true;
+    }
+};
+
+// Only handles Data and Stop. Ticks go straight to Top.
+class Receiving : public StateBase<VarFsmDesc, StateId::receiving>
+{
+  public:
+    explicit Receiving(StateArgs& args) : StateBase(args) {}
+
+    bool event(const Data& d)
+    {
+        fsm().receivingCalls++;
+        fsm().received += d.payload;
+        return true;
+    }
+
+    bool event(const Stop&)
+    {
+        fsm().receivingCalls++;
+        transition<Idle>();
+        return true;
+    }
+};
+
+void
+VarFsmDesc::setupStates(FsmSetup<VarFsmDesc>& sc)
+{
+    sc.addState<Top>();
+    sc.addState<Idle, Top>();
+    sc.addState<Receiving, Top>();
+}
+
+using Traits = FsmEventTraits<VarFsmDesc::Event>;
+
+} // namespace
+
+TEST(StateChartVariant, handled_masks)
+{
+    static_assert(Traits::handledMask<Top>() == 0x7, "");
+    static_assert(Traits::handledMask<Idle>() == 0x3, "");
+    static_assert(Traits::handledMask<Receiving>() == 0x6, "");
+}
+
+TEST(StateChartVariant, dispatch_per_type)
+{
+    VarFsm fsm;
+    fsm.setStartState(StateId::idle);
+
+    fsm.postEvent(Tick{5});
+    fsm.postEvent(Tick{7});
+    EXPECT_EQ(fsm.totalMs, 12);
+    EXPECT_EQ(fsm.idleCalls, 2);
+    EXPECT_EQ(fsm.topCalls, 0);
+
+    // Stop is not handled by Idle, Top gets it directly.
+    fsm.postEvent(Stop{});
+    EXPECT_EQ(fsm.idleCalls, 2);
+    EXPECT_EQ(fsm.topCalls, 1);
+
+    fsm.postEvent(Data{"ab"});
+    EXPECT_EQ(fsm.currentStateId(), StateId::receiving);
+    fsm.postEvent(Data{"cd"});
+    EXPECT_EQ(fsm.received, "abcd");
+
+    // Tick skips Receiving.
+    fsm.postEvent(Tick{1});
+    EXPECT_EQ(fsm.receivingCalls, 1);
+    EXPECT_EQ(fsm.topCalls, 2);
+    EXPECT_EQ(fsm.totalMs, 12);
+
+    fsm.postEvent(Stop{});
+    EXPECT_EQ(fsm.currentStateId(), StateId::idle);
+    EXPECT_EQ(fsm.receivingCalls, 2);
+}
+
+int
+main(int ac, char* av[])
+{
+    testing::InitGoogleTest(&ac, av);
+    return RUN_ALL_TESTS();
+}
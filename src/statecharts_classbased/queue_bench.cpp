@@ -0,0 +1,468 @@
+/*
+ * queue_bench.cpp
+ *
+ *  Benchmark of the event queue implementations. Run with 'make bench'.
+ *
+ *  Single threaded workloads, per element size:
+ *  - burst:   Push 64, then drain to empty. What VecQueue is built for.
+ *  - backlog: Keep 256 queued, one push and one pop per step. The queue
+ *             never drains.
+ *  - fill:    Push 10000, then drain all.
+ *  Reported as million push+pop pairs per second.
+ *
+ *  Cross thread: One producer thread, one consumer thread, 64 byte
+ *  elements. Lock free MpscQueue, the others behind a mutex. Reported as
+ *  unpaced throughput, and push to pop latency percentiles with the
+ *  producer sending one element per 5 us. MpscQueue with one producer is
+ *  also the SPSC case. Waiting threads yield, so the run also works on a
+ *  single core, where latency then includes a thread switch. Latency is
+ *  taken with timing::cycle_clock into a timing::log_histogram, so the
+ *  percentiles are bucket upper bounds, at most 6% above the true value.
+ *
+ *  Peak memory is the highest heap use during the run, plus the size of
+ *  the queue object. Built as C++17, so queues with alignas(64) members
+ *  get the aligned operator new and keep their cache line separation.
+ */
+
+#include "FixedQueue.h"
+#include "IntrusiveQueue.h"
+#include "MpscQueue.h"
+#include "VecQueue.h"
+
+#include "../timing/cycle_clock.h"
+#include "../timing/log_histogram.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// Heap use, tracked by the operator new below.
+std::atomic<long> heapNow{0};
+std::atomic<long> heapPeak{0};
+
+// Keep the size in a header in front of the block. The header is as
+// large as the alignment, so the block stays aligned.
+void*
+countedAlloc(std::size_t size, std::size_t align)
+{
+    const std::size_t header = std::max(align, alignof(std::max_align_t));
+    const std::size_t total = (size + 2 * header - 1) / header * header;
+    char* p = static_cast<char*>(std::aligned_alloc(header, total));
+    if (!p)
+        throw std::bad_alloc();
+    std::memcpy(p, &size, sizeof size);
+    long now = heapNow += long(size);
+    long peak = heapPeak.load();
+    while (now > peak && !heapPeak.compare_exchange_weak(peak, now))
+    {
+    }
+    return p + header;
+}
+
+void
+countedFree(void* ptr, std::size_t align)
+{
+    if (!ptr)
+        return;
+    const std::size_t header = std::max(align, alignof(std::max_align_t));
+    char* p = static_cast<char*>(ptr) - header;
+    std::size_t size;
+    std::memcpy(&size, p, sizeof size);
+    heapNow -= long(size);
+    std::free(p);
+}
+
+} // namespace
+
+void*
+operator new(std::size_t size)
+{
+    return countedAlloc(size, alignof(std::max_align_t));
+}
+
+// Used for over-aligned types, e.g. the alignas(64) indices in MpscQueue.
+void*
+operator new(std::size_t size, std::align_val_t align)
+{
+    return countedAlloc(size, std::size_t(align));
+}
+
+void
+operator delete(void* ptr) noexcept
+{
+    countedFree(ptr, alignof(std::max_align_t));
+}
+
+void
+operator delete(void* ptr, std::size_t) noexcept
+{
+    countedFree(ptr, alignof(std::max_align_t));
+}
+
+void
+operator delete(void* ptr, std::align_val_t align) noexcept
+{
+    countedFree(ptr, std::size_t(align));
+}
+
+void
+operator delete(void* ptr, std::size_t, std::align_val_t align) noexcept
+{
+    countedFree(ptr, std::size_t(align));
+}
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+template <std::size_t size>
+struct Elem
+{
+    uint32_t seq;
+    char payload[size - sizeof(uint32_t)];
+};
+
+template <>
+struct Elem<4>
+{
+    uint32_t seq;
+};
+
+template <std::size_t size>
+struct Node : IntrusiveHook
+{
+    Elem<size> elem;
+};
+
+enum
+{
+    maxDepth = 16384,
+};
+
+// Uniform push/pop over all queues. push returns false when full.
+template <class E>
+struct VecQ
+{
+    static const char* name()
+    {
+        return "VecQueue";
+    }
+    bool push(const E& e)
+    {
+        q.push(e);
+        return true;
+    }
+    bool pop(E& e)
+    {
+        if (q.empty())
+            return false;
+        e = q.front();
+        q.pop();
+        return true;
+    }
+    VecQueue<E> q;
+};
+
+template <class E>
+struct DequeQ
+{
+    static const char* name()
+    {
+        return "std::deque";
+    }
+    bool push(const E& e)
+    {
+        q.push_back(e);
+        return true;
+    }
+    bool pop(E& e)
+    {
+        if (q.empty())
+            return false;
+        e = q.front();
+        q.pop_front();
+        return true;
+    }
+    std::deque<E> q;
+};
+
+template <class E>
+struct FixedQ
+{
+    static const char* name()
+    {
+        return "FixedQueue";
+    }
+    bool push(const E& e)
+    {
+        if (q.full())
+            return false;
+        q.push(e);
+        return true;
+    }
+    bool pop(E& e)
+    {
+        if (q.empty())
+            return false;
+        e = q.front();
+        q.pop();
+        return true;
+    }
+    FixedQueue<E, maxDepth> q;
+};
+
+template <class E>
+struct MpscQ
+{
+    static const char* name()
+    {
+        return "MpscQueue";
+    }
+    bool push(const E& e)
+    {
+        return q.push(e);
+    }
+    bool pop(E& e)
+    {
+        if (q.empty())
+            return false;
+        e = q.front();
+        q.pop();
+        return true;
+    }
+    MpscQueue<E, maxDepth> q;
+};
+
+// Elements are copied into pooled nodes and passed by link. The full
+// element is copied in and out, as for the other queues, so rows compare
+// at each element size.
+template <class E>
+struct IntrusiveQ
+{
+    using N = Node<sizeof(E)>;
+    static const char* name()
+    {
+        return "IntrusiveQueue";
+    }
+    bool push(const E& e)
+    {
+        N* n = pool.acquire();
+        if (!n)
+            return false;
+        n->elem = e;
+        q.push(n);
+        return true;
+    }
+    bool pop(E& e)
+    {
+        if (q.empty())
+            return false;
+        e = q.front()->elem;
+        q.pop();
+        return true;
+    }
+    EventPool<N, maxDepth> pool;
+    IntrusiveQueue<N> q;
+};
+
+struct Result
+{
+    double mops;
+    long peakBytes;
+};
+
+// Run 'work' on a fresh heap allocated queue, return ops/s and memory.
+template <class Q, class Work>
+Result
+measure(long pairs, Work work)
+{
+    const long base = heapNow.load();
+    heapPeak = base;
+    auto q = std::unique_ptr<Q>(new Q);
+    const auto t0 = Clock::now();
+    work(*q);
+    const std::chrono::duration<double> s = Clock::now() - t0;
+    q.reset();
+    return Result{pairs / s.count() / 1e6, heapPeak.load() - base};
+}
+
+template <class Q, class E>
+void
+singleThread(long scale)
+{
+    E e{};
+    E out{};
+    const long rounds = scale * 2000;
+
+    Result burst = measure<Q>(rounds * 64, [&](Q& q) {
+        for (long r = 0; r < rounds; ++r)
+        {
+            for (int i = 0; i < 64; ++i)
+            {
+                e.seq = i;
+                q.push(e);
+            }
+            while (q.pop(out))
+            {
+            }
+        }
+    });
+
+    const long steps = rounds * 64;
+    Result backlog = measure<Q>(steps, [&](Q& q) {
+        for (int i = 0; i < 256; ++i)
+            q.push(e);
+        for (long i = 0; i < steps; ++i)
+        {
+            e.seq = uint32_t(i);
+            q.push(e);
+            q.pop(out);
+        }
+        while (q.pop(out))
+        {
+        }
+    });
+
+    const long fills = std::max(1L, rounds / 150);
+    Result fill = measure<Q>(fills * 10000, [&](Q& q) {
+        for (long r = 0; r < fills; ++r)
+        {
+            for (int i = 0; i < 10000; ++i)
+                q.push(e);
+            while (q.pop(out))
+            {
+            }
+        }
+    });
+
+    const long peak =
+        std::max({burst.peakBytes, backlog.peakBytes, fill.peakBytes});
+    std::printf("%-15s %5zu  %8.1f %8.1f %8.1f  %10ld\n", Q::name(),
+                sizeof(E), burst.mops, backlog.mops, fill.mops, peak);
+}
+
+template <class E>
+void
+singleThreadAll(long scale)
+{
+    singleThread<VecQ<E>, E>(scale);
+    singleThread<DequeQ<E>, E>(scale);
+    singleThread<FixedQ<E>, E>(scale);
+    singleThread<MpscQ<E>, E>(scale);
+    singleThread<IntrusiveQ<E>, E>(scale);
+}
+
+// Move n elements from a producer thread to this thread. With 'period'
+// non zero, the producer sends one element per period and the push to pop
+// latency of each element, in cycle_clock ticks, is recorded in 'latency'.
+template <class Q, class E, bool lockFree>
+Result
+handoff(long n, Clock::duration period, timing::log_histogram<>& latency)
+{
+    using timing::cycle_clock;
+    std::vector<cycle_clock::rep> pushed(n);
+    std::mutex m;
+
+    auto push = [&](Q& q, const E& e) {
+        if (lockFree)
+            return q.push(e);
+        std::lock_guard<std::mutex> lk(m);
+        return q.push(e);
+    };
+    auto pop = [&](Q& q, E& e) {
+        if (lockFree)
+            return q.pop(e);
+        std::lock_guard<std::mutex> lk(m);
+        return q.pop(e);
+    };
+
+    return measure<Q>(n, [&](Q& q) {
+        std::thread producer([&] {
+            E e{};
+            auto next = Clock::now();
+            for (long i = 0; i < n; ++i)
+            {
+                if (period.count())
+                {
+                    next += period;
+                    while (Clock::now() < next)
+                        std::this_thread::yield();
+                }
+                e.seq = uint32_t(i);
+                pushed[i] = cycle_clock::now();
+                while (!push(q, e))
+                    std::this_thread::yield();
+            }
+        });
+        E e{};
+        for (long i = 0; i < n;)
+        {
+            if (!pop(q, e))
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            if (period.count())
+                latency.record(cycle_clock::now() - pushed[e.seq]);
+            ++i;
+        }
+        producer.join();
+    });
+}
+
+// Unpaced throughput, then latency with one element per 5 us.
+template <class Q, class E, bool lockFree>
+void
+crossThread(long scale)
+{
+    timing::log_histogram<> latency;
+    Result res = handoff<Q, E, lockFree>(scale * 200000,
+                                         Clock::duration(0), latency);
+    handoff<Q, E, lockFree>(scale * 20000, std::chrono::microseconds(5),
+                            latency);
+    const auto s = latency.snapshot();
+    auto pct = [&](double p) {
+        return long(timing::cycle_clock::to_ns(s.percentile(p)));
+    };
+    std::printf("%-15s %8.1f  %8ld %8ld %8ld  %10ld\n", Q::name(), res.mops,
+                pct(0.5), pct(0.99), pct(0.999), res.peakBytes);
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+    const long scale = argc > 1 ? std::atol(argv[1]) : 1;
+
+    std::printf("Single thread, million push+pop per second\n");
+    std::printf("%-15s %5s  %8s %8s %8s  %10s\n", "queue", "bytes", "burst",
+                "backlog", "fill", "peak mem");
+    singleThreadAll<Elem<4>>(scale);
+    singleThreadAll<Elem<64>>(scale);
+    singleThreadAll<Elem<1024>>(scale);
+
+    std::printf("\nCross thread handoff, 64 byte elements, latency in ns\n");
+    std::printf("%-15s %8s  %8s %8s %8s  %10s\n", "queue", "Mops/s", "p50",
+                "p99", "p99.9", "peak mem");
+    using E64 = Elem<64>;
+    crossThread<VecQ<E64>, E64, false>(scale);
+    crossThread<DequeQ<E64>, E64, false>(scale);
+    crossThread<FixedQ<E64>, E64, false>(scale);
+    crossThread<IntrusiveQ<E64>, E64, false>(scale);
+    crossThread<MpscQ<E64>, E64, true>(scale);
+    return 0;
+}
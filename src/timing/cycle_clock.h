@@ -0,0 +1,296 @@
+/*
+ * cycle_clock.h
+ *
+ *  Portable cycle counter for instrumentation and benchmarks.
+ */
+
+#ifndef SRC_TIMING_CYCLE_CLOCK_H_
+#define SRC_TIMING_CYCLE_CLOCK_H_
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * timing::cycle_clock is the finest clock each platform offers, cheap
+ * enough to read around single interrupts or events:
+ *
+ * timing::cycle_clock::init();  // Once at startup.
+ * auto t0 = timing::cycle_clock::now();
+ * ...
+ * uint64_t ns = timing::cycle_clock::to_ns(timing::cycle_clock::now() - t0);
+ *
+ * Differences are taken in the unsigned 'rep' type, so they are right
+ * across a wrap of the counter, for intervals shorter than a full wrap.
+ * now() is static, so the clock also fits as 'Clock' parameter in e.g.
+ * FsmExplorer.
+ *
+ * Platforms:
+ * - Cortex M3-7: DWT CYCCNT, core clock cycles, 32 bit.
+ * - Cortex M0: No cycle counter. SysTick, extended to 32 bit by counting
+ *   wraps in the SysTick handler.
+ * - Linux x86: TSC, calibrated against CLOCK_MONOTONIC at first use.
+ * - Other Linux: CLOCK_MONOTONIC in ns.
+ *
+ * On Cortex M, set the core clock with set_frequency() before to_ns().
+ */
+
+namespace timing
+{
+namespace details
+{
+
+// Ticks to ns without overflowing for large tick counts.
+inline uint64_t
+ticksToNs(uint64_t ticks, uint64_t frequency)
+{
+    const uint64_t s = ticks / frequency;
+    const uint64_t rest = ticks % frequency;
+    return s * 1000000000u + rest * 1000000000u / frequency;
+}
+} // namespace details
+} // namespace timing
+
+// Cortex M3-7.
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+
+namespace timing
+{
+namespace arch_armv7_m
+{
+
+class cycle_clock
+{
+  public:
+    using rep = uint32_t;
+
+    // Enable the trace unit and start the cycle counter.
+    static void init()
+    {
+        reg(demcr) |= 1u << 24; // TRCENA
+        reg(cyccnt) = 0;
+        reg(dwtCtrl) |= 1u; // CYCCNTENA
+    }
+
+    static rep now()
+    {
+        return reg(cyccnt);
+    }
+
+    static void set_frequency(uint32_t hz)
+    {
+        hertz() = hz;
+    }
+
+    static uint64_t frequency()
+    {
+        return hertz();
+    }
+
+    static uint64_t to_ns(uint64_t ticks)
+    {
+        return details::ticksToNs(ticks, hertz());
+    }
+
+  private:
+    enum : uint32_t
+    {
+        demcr = 0xe000edfc,
+        dwtCtrl = 0xe0001000,
+        cyccnt = 0xe0001004,
+    };
+
+    static volatile uint32_t& reg(uint32_t addr)
+    {
+        return *reinterpret_cast<volatile uint32_t*>(addr);
+    }
+
+    static uint32_t& hertz()
+    {
+        static uint32_t hz = 1;
+        return hz;
+    }
+};
+} // namespace arch_armv7_m
+
+using cycle_clock = arch_armv7_m::cycle_clock;
+} // namespace timing
+
+// Cortex M0.
+#elif defined(__ARM_ARCH_6M__)
+
+namespace timing
+{
+namespace arch_armv6_m
+{
+
+/**
+ * SysTick counts down from 'reload' at the core clock. Call on_systick()
+ * from SysTick_Handler. If the application already uses SysTick, pass
+ * its reload value and call on_systick() from its handler.
+ */
+class cycle_clock
+{
+  public:
+    using rep = uint32_t;
+
+    static void init(uint32_t reloadValue = 0xffffff)
+    {
+        reload() = reloadValue;
+        reg(systLoad) = reloadValue;
+        reg(systVal) = 0;
+        // Core clock, interrupt, enable.
+        reg(systCsr) = 0x7;
+    }
+
+    // Call from SysTick_Handler.
+    static void on_systick()
+    {
+        // Only the handler writes, no read-modify-write needed.
+        wraps().store(wraps().load(std::memory_order_relaxed) + 1,
+                      std::memory_order_relaxed);
+    }
+
+    // With interrupts disabled across a SysTick wrap, the result is one
+    // period behind until the handler has run.
+    static rep now()
+    {
+        uint32_t count;
+        uint32_t val;
+        do
+        {
+            count = wraps().load(std::memory_order_relaxed);
+            val = reg(systVal);
+        } while (count != wraps().load(std::memory_order_relaxed));
+        return count * (reload() + 1) + (reload() - val);
+    }
+
+    static void set_frequency(uint32_t hz)
+    {
+        hertz() = hz;
+    }
+
+    static uint64_t frequency()
+    {
+        return hertz();
+    }
+
+    static uint64_t to_ns(uint64_t ticks)
+    {
+        return details::ticksToNs(ticks, hertz());
+    }
+
+  private:
+    enum : uint32_t
+    {
+        systCsr = 0xe000e010,
+        systLoad = 0xe000e014,
+        systVal = 0xe000e018,
+    };
+
+    static volatile uint32_t& reg(uint32_t addr)
+    {
+        return *reinterpret_cast<volatile uint32_t*>(addr);
+    }
+
+    static std::atomic<uint32_t>& wraps()
+    {
+        static std::atomic<uint32_t> count{0};
+        return count;
+    }
+
+    static uint32_t& reload()
+    {
+        static uint32_t value = 0xffffff;
+        return value;
+    }
+
+    static uint32_t& hertz()
+    {
+        static uint32_t hz = 1;
+        return hz;
+    }
+};
+} // namespace arch_armv6_m
+
+using cycle_clock = arch_armv6_m::cycle_clock;
+} // namespace timing
+
+#elif defined(__linux__)
+
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace timing
+{
+namespace arch_linux
+{
+
+class cycle_clock
+{
+  public:
+    using rep = uint64_t;
+
+    static void init()
+    {
+        frequency();
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    static rep now()
+    {
+        return __rdtsc();
+    }
+
+    // TSC ticks per second, measured once.
+    static uint64_t frequency()
+    {
+        static const uint64_t hz = calibrate();
+        return hz;
+    }
+#else
+    static rep now()
+    {
+        return monotonicNs();
+    }
+
+    static uint64_t frequency()
+    {
+        return 1000000000u;
+    }
+#endif
+
+    static uint64_t to_ns(uint64_t ticks)
+    {
+        return details::ticksToNs(ticks, frequency());
+    }
+
+  private:
+    static uint64_t monotonicNs()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return uint64_t(ts.tv_sec) * 1000000000u + uint64_t(ts.tv_nsec);
+    }
+
+    static uint64_t calibrate()
+    {
+        const uint64_t ns0 = monotonicNs();
+        const uint64_t t0 = now();
+        while (monotonicNs() - ns0 < 10000000)
+        {
+        }
+        const uint64_t ns = monotonicNs() - ns0;
+        const uint64_t ticks = now() - t0;
+        return ticks * 1000000000u / ns;
+    }
+};
+} // namespace arch_linux
+
+using cycle_clock = arch_linux::cycle_clock;
+} // namespace timing
+
+#endif
+
+#endif /* SRC_TIMING_CYCLE_CLOCK_H_ */
@@ -0,0 +1,194 @@
+/*
+ * log_histogram.h
+ *
+ *  Fixed size log-linear histogram with lock free recording.
+ */
+
+#ifndef SRC_TIMING_LOG_HISTOGRAM_H_
+#define SRC_TIMING_LOG_HISTOGRAM_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Histogram of unsigned values, e.g. latencies in cycle_clock ticks, with
+ * bounded relative error and no allocation:
+ *
+ * timing::log_histogram<> h;          // Static, or in the object measured.
+ * h.record(timing::cycle_clock::now() - t0);  // From any thread or ISR.
+ * auto s = h.snapshot();
+ * s.percentile(0.99);
+ *
+ * Values below 2^subBits get a bucket each. Above that every power of two
+ * range is split into 2^subBits linear buckets, so a bucket is at most
+ * 1 / 2^subBits of its values wide. Values from 2^valueBits up go in the
+ * last bucket. The defaults, 4 and 32, give 464 buckets and 6.25% error.
+ *
+ * record() is lock free, a relaxed atomic increment of one counter. On
+ * Cortex M0, which lacks atomic read-modify-write, it is a load and a
+ * store, so each histogram must then have a single writer.
+ *
+ * snapshot() copies the counters into a plain log_snapshot, which can be
+ * merged with snapshots from other histograms, e.g. one per thread or
+ * per ISR, and queried for percentiles. Counts recorded during the copy
+ * may or may not be included.
+ */
+
+namespace timing
+{
+
+template <unsigned subBits, unsigned valueBits>
+struct log_buckets
+{
+    static_assert(subBits >= 1 && subBits < valueBits && valueBits <= 64,
+                  "Bad bucket layout");
+
+    enum : std::size_t
+    {
+        sub = std::size_t(1) << subBits,
+        count = (valueBits - subBits + 1) * sub,
+    };
+
+    static std::size_t index(uint64_t v)
+    {
+        if (v < sub)
+            return std::size_t(v);
+        const unsigned msb = 63 - unsigned(__builtin_clzll(v));
+        if (msb >= valueBits)
+            return count - 1;
+        const unsigned shift = msb - subBits;
+        return (shift + 1) * sub + std::size_t((v >> shift) - sub);
+    }
+
+    // Smallest value in bucket 'i'.
+    static uint64_t low(std::size_t i)
+    {
+        if (i < sub)
+            return i;
+        const unsigned shift = unsigned(i / sub) - 1;
+        return uint64_t(sub + i % sub) << shift;
+    }
+
+    // Largest value in bucket 'i'. The last bucket is open ended.
+    static uint64_t high(std::size_t i)
+    {
+        if (i == count - 1)
+            return ~uint64_t(0);
+        return low(i + 1) - 1;
+    }
+};
+
+/**
+ * Plain copy of histogram counters. Merge with +=.
+ */
+template <unsigned subBits = 4, unsigned valueBits = 32>
+class log_snapshot
+{
+  public:
+    using buckets = log_buckets<subBits, valueBits>;
+
+    uint64_t counts[buckets::count] = {};
+
+    log_snapshot& operator+=(const log_snapshot& other)
+    {
+        for (std::size_t i = 0; i < buckets::count; ++i)
+            counts[i] += other.counts[i];
+        return *this;
+    }
+
+    uint64_t total() const
+    {
+        uint64_t n = 0;
+        for (uint64_t c : counts)
+            n += c;
+        return n;
+    }
+
+    /**
+     * Value at or below which a fraction 'p' of the values are, reported
+     * as the largest value of its bucket. 0 if empty.
+     */
+    uint64_t percentile(double p) const
+    {
+        const uint64_t n = total();
+        if (n == 0)
+            return 0;
+        uint64_t rank = uint64_t(p * double(n - 1)) + 1;
+        for (std::size_t i = 0; i < buckets::count; ++i)
+        {
+            if (counts[i] >= rank)
+                return buckets::high(i);
+            rank -= counts[i];
+        }
+        return buckets::high(buckets::count - 1);
+    }
+
+    // Mean, using the middle of each bucket.
+    double mean() const
+    {
+        double sum = 0;
+        uint64_t n = 0;
+        for (std::size_t i = 0; i < buckets::count; ++i)
+        {
+            const double mid =
+                (double(buckets::low(i)) + double(buckets::high(i))) / 2;
+            sum += mid * double(counts[i]);
+            n += counts[i];
+        }
+        return n ? sum / double(n) : 0.0;
+    }
+
+    // Largest value of the highest non empty bucket. 0 if empty.
+    uint64_t max() const
+    {
+        for (std::size_t i = buckets::count; i > 0; --i)
+            if (counts[i - 1])
+                return buckets::high(i - 1);
+        return 0;
+    }
+};
+
+template <unsigned subBits = 4, unsigned valueBits = 32>
+class log_histogram
+{
+  public:
+    using buckets = log_buckets<subBits, valueBits>;
+    using snapshot_type = log_snapshot<subBits, valueBits>;
+
+    log_histogram() = default;
+    log_histogram(const log_histogram&) = delete;
+    log_histogram& operator=(const log_histogram&) = delete;
+
+    void record(uint64_t v)
+    {
+        std::atomic<uint32_t>& c = m_counts[buckets::index(v)];
+#if defined(__ARM_ARCH_6M__)
+        c.store(c.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+#else
+        c.fetch_add(1, std::memory_order_relaxed);
+#endif
+    }
+
+    snapshot_type snapshot() const
+    {
+        snapshot_type s;
+        for (std::size_t i = 0; i < buckets::count; ++i)
+            s.counts[i] = m_counts[i].load(std::memory_order_relaxed);
+        return s;
+    }
+
+    // Not atomic with respect to concurrent record() calls.
+    void reset()
+    {
+        for (auto& c : m_counts)
+            c.store(0, std::memory_order_relaxed);
+    }
+
+  private:
+    std::atomic<uint32_t> m_counts[buckets::count] = {};
+};
+} // namespace timing
+
+#endif /* SRC_TIMING_LOG_HISTOGRAM_H_ */
@@ -0,0 +1,126 @@
+/*
+ * timing_test.cpp
+ *
+ *  Test of the cycle clock and the log histogram.
+ */
+#include "cycle_clock.h"
+#include "log_histogram.h"
+
+#include <assert.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using Hist = timing::log_histogram<>;
+using Buckets = Hist::buckets;
+
+void
+test_buckets()
+{
+    static_assert(Buckets::count == 464, "Default layout");
+
+    // Small values are exact.
+    for (uint64_t v = 0; v < 16; ++v)
+        assert(Buckets::index(v) == v);
+
+    // Every value is within its bucket, buckets are contiguous and each
+    // is at most 1/16 of its values wide.
+    for (std::size_t i = 0; i + 1 < Buckets::count; ++i)
+    {
+        const uint64_t lo = Buckets::low(i);
+        const uint64_t hi = Buckets::high(i);
+        assert(Buckets::index(lo) == i && Buckets::index(hi) == i);
+        assert(Buckets::low(i + 1) == hi + 1);
+        assert((hi - lo) * 16 <= lo || lo < 16);
+    }
+    for (uint64_t v : {1000ull, 123456ull, 0xffffffffull})
+        assert(Buckets::low(Buckets::index(v)) <= v &&
+               v <= Buckets::high(Buckets::index(v)));
+
+    // Large values saturate.
+    assert(Buckets::index(uint64_t(1) << 40) == Buckets::count - 1);
+    assert(Buckets::index(~uint64_t(0)) == Buckets::count - 1);
+}
+
+void
+test_percentile()
+{
+    Hist h;
+    assert(h.snapshot().total() == 0);
+    assert(h.snapshot().percentile(0.5) == 0);
+
+    for (uint64_t v = 1; v <= 1000; ++v)
+        h.record(v);
+    auto s = h.snapshot();
+    assert(s.total() == 1000);
+
+    // Reported values are bucket upper bounds: not below the true value,
+    // and at most 1/16 above it.
+    const uint64_t p50 = s.percentile(0.5);
+    const uint64_t p99 = s.percentile(0.99);
+    assert(p50 >= 500 && p50 <= 500 + 500 / 16);
+    assert(p99 >= 990 && p99 <= 990 + 990 / 16);
+    assert(s.percentile(0.0) == 1);
+    assert(s.max() >= 1000 && s.max() <= 1000 + 1000 / 16);
+    assert(s.mean() > 480 && s.mean() < 520);
+
+    // Merge.
+    Hist other;
+    for (int i = 0; i < 1000; ++i)
+        other.record(100000);
+    s += other.snapshot();
+    assert(s.total() == 2000);
+    assert(s.percentile(0.25) <= 520);
+    assert(s.percentile(0.75) >= 100000);
+
+    h.reset();
+    assert(h.snapshot().total() == 0);
+}
+
+void
+test_threaded()
+{
+    enum
+    {
+        threads = 4,
+        perThread = 100000,
+    };
+    static Hist h;
+    std::vector<std::thread> t;
+    for (int i = 0; i < threads; ++i)
+        t.emplace_back([i] {
+            for (int n = 0; n < perThread; ++n)
+                h.record(uint64_t(n % 64 + i));
+        });
+    for (auto& th : t)
+        th.join();
+    assert(h.snapshot().total() == threads * perThread);
+}
+
+void
+test_clock()
+{
+    using timing::cycle_clock;
+    cycle_clock::init();
+    assert(cycle_clock::frequency() > 0);
+
+    const cycle_clock::rep t0 = cycle_clock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const cycle_clock::rep t1 = cycle_clock::now();
+    assert(t1 > t0);
+
+    // Allow for a loaded host.
+    const uint64_t ns = cycle_clock::to_ns(t1 - t0);
+    assert(ns >= 19000000 && ns < 2000000000);
+
+    assert(cycle_clock::to_ns(cycle_clock::frequency()) == 1000000000);
+}
+
+int
+main()
+{
+    test_buckets();
+    test_percentile();
+    test_threaded();
+    test_clock();
+}
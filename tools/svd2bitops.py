@@ -0,0 +1,349 @@
+#!/usr/bin/env python3
+"""
+Generate bitops register definitions from a CMSIS-SVD file.
+
+For each peripheral a namespace is emitted. Each register becomes a struct
+inheriting bitops::Register with its address, reset value and access policy.
+Fields become nested bitops::RegField types, and fields with enumerated
+values get a nested 'enum class <FIELD>_t' used as field type.
+
+Example of generated code:
+
+    namespace USART1
+    {
+    constexpr uintptr_t baseAddress = 0x40011000u;
+
+    // Control register 1
+    struct CR1 : bitops::Register<uint32_t, 0x4001100cu, 0x00000000u,
+                                  bitops::access::ReadWrite>
+    {
+        // USART enable
+        using UE = bitops::RegField<CR1, uint32_t, 13, 1>;
+    };
+    } // namespace USART1
+
+Usage:
+    svd2bitops.py device.svd -o device_regs.h [--namespace name]
+
+'make -C tools test' generates a header from svd2bitops_test.svd and
+compiles it with checks of the generated registers and fields.
+"""
+
+import argparse
+import copy
+import re
+import sys
+import xml.etree.ElementTree as ET
+
+CPP_KEYWORDS = {
+    "alignas", "alignof", "and", "asm", "auto", "bool", "break", "case",
+    "catch", "char", "class", "const", "constexpr", "continue", "default",
+    "delete", "do", "double", "else", "enum", "explicit", "export", "extern",
+    "false", "float", "for", "friend", "goto", "if", "inline", "int", "long",
+    "mutable", "namespace", "new", "noexcept", "not", "nullptr", "operator",
+    "or", "private", "protected", "public", "register", "return", "short",
+    "signed", "sizeof", "static", "struct", "switch", "template", "this",
+    "throw", "true", "try", "typedef", "typename", "union", "unsigned",
+    "using", "virtual", "void", "volatile", "while", "xor",
+}
+
+# Names used by the bitops::Register base class.
+RESERVED_MEMBERS = {"RegStorage", "Access", "address", "resetValue", "ref"}
+
+ACCESS = {
+    "read-only": "bitops::access::ReadOnly",
+    "write-only": "bitops::access::WriteOnly",
+    "read-write": "bitops::access::ReadWrite",
+    "writeOnce": "bitops::access::WriteOnly",
+    "read-writeOnce": "bitops::access::ReadWrite",
+}
+
+STORAGE = {8: "uint8_t", 16: "uint16_t", 32: "uint32_t", 64: "uint64_t"}
+
+
+def parse_int(text):
+    """Parse an SVD scaled non negative integer."""
+    text = text.strip().lower()
+    if text.startswith("#"):
+        return int(text[1:].replace("x", "0"), 2)
+    if text.startswith("0x"):
+        return int(text, 16)
+    if text.startswith("0b"):
+        return int(text[2:], 2)
+    return int(text, 10)
+
+
+def ident(name):
+    """Turn an SVD name into a valid C++ identifier."""
+    name = re.sub(r"[^A-Za-z0-9_]", "_", name.strip())
+    if not name or name[0].isdigit():
+        name = "v" + name
+    if name.startswith("_") or name in CPP_KEYWORDS:
+        name = "v" + name
+    return name
+
+
+def text(node, tag, default=None):
+    el = node.find(tag)
+    return el.text.strip() if el is not None and el.text else default
+
+
+def comment(desc):
+    if not desc:
+        return None
+    return " ".join(desc.split())
+
+
+class Props:
+    """Register properties inherited from device, peripheral and cluster."""
+
+    def __init__(self, size=32, access="read-write", reset=0):
+        self.size = size
+        self.access = access
+        self.reset = reset
+
+    def derive(self, node):
+        p = copy.copy(self)
+        size = text(node, "size")
+        if size:
+            p.size = parse_int(size)
+        access = text(node, "access")
+        if access:
+            p.access = access
+        reset = text(node, "resetValue")
+        if reset:
+            p.reset = parse_int(reset)
+        return p
+
+
+def field_range(field):
+    """Return (offset, width) of a field given any of the SVD variants."""
+    offset = text(field, "bitOffset")
+    if offset is not None:
+        return parse_int(offset), parse_int(text(field, "bitWidth", "1"))
+    lsb = text(field, "lsb")
+    if lsb is not None:
+        lsb = parse_int(lsb)
+        return lsb, parse_int(text(field, "msb")) - lsb + 1
+    rng = text(field, "bitRange")
+    m = re.match(r"\[(\d+):(\d+)\]", rng or "")
+    if not m:
+        raise ValueError("Field %s lacks bit range" % text(field, "name"))
+    msb, lsb = int(m.group(1)), int(m.group(2))
+    return lsb, msb - lsb + 1
+
+
+def dim_names(node, name):
+    """Expand 'dim' arrays. Return list of (name, index)."""
+    dim = text(node, "dim")
+    if dim is None:
+        return [(name, 0)]
+    count = parse_int(dim)
+    index = text(node, "dimIndex")
+    if index:
+        if "-" in index and "," not in index:
+            a, b = index.split("-")
+            if a.isdigit():
+                labels = [str(i) for i in range(int(a), int(b) + 1)]
+            else:
+                labels = [chr(c) for c in range(ord(a), ord(b) + 1)]
+        else:
+            labels = index.split(",")
+    else:
+        labels = [str(i) for i in range(count)]
+    res = []
+    for i, label in enumerate(labels[:count]):
+        if "[%s]" in name:
+            res.append((name.replace("[%s]", label), i))
+        else:
+            res.append((name.replace("%s", label), i))
+    return res
+
+
+class Generator:
+    def __init__(self, root):
+        self.root = root
+        self.out = []
+        self.peripherals = {}
+
+    def emit(self, line=""):
+        self.out.append(line)
+
+    def run(self, ns):
+        dev = self.root
+        name = text(dev, "name", "device")
+        ns = ns or ident(name.lower())
+        props = Props().derive(dev)
+
+        for p in dev.iter("peripheral"):
+            self.peripherals[text(p, "name")] = p
+
+        self.emit("// Generated by svd2bitops.py from %s. Do not edit." % name)
+        self.emit()
+        self.emit("#pragma once")
+        self.emit()
+        self.emit('#include "register.h"')
+        self.emit()
+        self.emit("#include <cstdint>")
+        self.emit()
+        self.emit("namespace %s" % ns)
+        self.emit("{")
+        for p in dev.find("peripherals").findall("peripheral"):
+            self.peripheral(p, props)
+        self.emit("} // namespace %s" % ns)
+        return "\n".join(self.out) + "\n"
+
+    def peripheral(self, p, props):
+        name = ident(text(p, "name"))
+        base = parse_int(text(p, "baseAddress"))
+        src = p
+        derived = p.get("derivedFrom")
+        if derived is not None:
+            src = self.peripherals[derived]
+            props = props.derive(src)
+        props = props.derive(p)
+
+        self.emit()
+        desc = comment(text(p, "description") or text(src, "description"))
+        if desc:
+            self.emit("// %s" % desc)
+        self.emit("namespace %s" % name)
+        self.emit("{")
+        self.emit("constexpr uintptr_t baseAddress = 0x%08xu;" % base)
+
+        regs = p.find("registers")
+        if regs is None:
+            regs = src.find("registers")
+        if regs is not None:
+            self.registers(regs, base, props, "")
+        self.emit("} // namespace %s" % name)
+
+    def registers(self, regs, base, props, prefix):
+        for node in regs:
+            if node.tag == "register":
+                self.register(node, base, props, prefix)
+            elif node.tag == "cluster":
+                cprops = props.derive(node)
+                offset = parse_int(text(node, "addressOffset"))
+                inc = parse_int(text(node, "dimIncrement", "0"))
+                for cname, i in dim_names(node, text(node, "name")):
+                    self.registers(node, base + offset + i * inc, cprops,
+                                   prefix + ident(cname) + "_")
+
+    def register(self, reg, base, props, prefix):
+        props = props.derive(reg)
+        storage = STORAGE.get(props.size)
+        if storage is None:
+            sys.stderr.write("Skipping register %s with size %d\n" %
+                             (text(reg, "name"), props.size))
+            return
+        offset = parse_int(text(reg, "addressOffset"))
+        inc = parse_int(text(reg, "dimIncrement", "0"))
+        access = ACCESS.get(props.access, ACCESS["read-write"])
+        desc = comment(text(reg, "description"))
+
+        for rname, i in dim_names(reg, text(reg, "name")):
+            rname = prefix + ident(rname)
+            addr = base + offset + i * inc
+            self.emit()
+            if desc:
+                self.emit("// %s" % desc)
+            self.emit("struct %s : bitops::Register<%s, 0x%08xu, 0x%0*xu," %
+                      (rname, storage, addr, props.size // 4, props.reset))
+            self.emit("%s%s>" % (" " * (len(rname) + 27), access))
+            self.emit("{")
+            fields = reg.find("fields")
+            first = True
+            for f in fields.findall("field") if fields is not None else []:
+                if not first:
+                    self.emit()
+                first = False
+                self.field(f, rname, storage, props.access)
+            self.emit("};")
+
+    def field(self, f, rname, storage, regAccess):
+        fname = ident(text(f, "name"))
+        if fname == rname or fname in RESERVED_MEMBERS:
+            fname = fname + "_"
+        offset, width = field_range(f)
+        desc = comment(text(f, "description"))
+        if desc:
+            self.emit("    // %s" % desc)
+
+        ftype = storage
+        enums = self.enum_values(f)
+        if enums:
+            ftype = fname + "_t"
+            self.emit("    enum class %s : %s" % (ftype, storage))
+            self.emit("    {")
+            for ename, value, edesc in enums:
+                line = "        %s = 0x%xu," % (ename, value)
+                if edesc:
+                    line += " // %s" % edesc
+                self.emit(line)
+            self.emit("    };")
+
+        access = text(f, "access")
+        args = "%s, %s, %d, %d" % (rname, ftype, offset, width)
+        if access and access != regAccess and access in ACCESS:
+            args += ", %s" % ACCESS[access]
+        line = "    using %s = bitops::RegField<%s>;" % (fname, args)
+        if len(line) > 80:
+            self.emit("    using %s =" % fname)
+            self.emit("        bitops::RegField<%s>;" % args)
+        else:
+            self.emit(line)
+
+    def enum_values(self, f):
+        sets = f.findall("enumeratedValues")
+        if not sets:
+            return []
+        chosen = sets[0]
+        for s in sets:
+            if text(s, "usage", "read-write") in ("write", "read-write"):
+                chosen = s
+                break
+        derived = chosen.get("derivedFrom")
+        if derived is not None:
+            chosen = self.find_enum_set(derived) or chosen
+        res = []
+        names = set()
+        for ev in chosen.findall("enumeratedValue"):
+            value = text(ev, "value")
+            if value is None or "x" in value.lower().lstrip("0x#"):
+                # 'isDefault' entries and don't care bits have no value.
+                continue
+            name = ident(text(ev, "name"))
+            if name in names:
+                continue
+            names.add(name)
+            res.append((name, parse_int(value),
+                        comment(text(ev, "description"))))
+        return res
+
+    def find_enum_set(self, name):
+        for s in self.root.iter("enumeratedValues"):
+            if text(s, "name") == name.split(".")[-1]:
+                return s
+        return None
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    ap.add_argument("svd", help="CMSIS-SVD input file.")
+    ap.add_argument("-o", "--output", help="Output header, default stdout.")
+    ap.add_argument("--namespace", help="Top level namespace. Default is "
+                    "the lower case device name.")
+    args = ap.parse_args()
+
+    root = ET.parse(args.svd).getroot()
+    res = Generator(root).run(args.namespace)
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(res)
+    else:
+        sys.stdout.write(res)
+
+
+if __name__ == "__main__":
+    main()
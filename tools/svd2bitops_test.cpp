@@ -0,0 +1,81 @@
+/*
+ * svd2bitops_test.cpp
+ *
+ *  Compile test of the header svd2bitops.py generates from
+ *  svd2bitops_test.svd. Run with 'make -C tools test'.
+ */
+
+#include "svd2bitops_test.h"
+
+#include <type_traits>
+
+namespace
+{
+
+using namespace testdev;
+
+template <class RF>
+using FieldOf = typename RF::Field;
+
+// Register addresses, reset values and storage.
+static_assert(TIM1::CR1::address() == 0x40010000u, "");
+static_assert(TIM1::CR1::resetValue() == 0x100u, "");
+static_assert(TIM1::SR::address() == 0x40010010u, "");
+static_assert(std::is_same<TIM1::CR1::RegStorage, uint32_t>::value, "");
+
+// bitOffset/bitWidth, bitRange and lsb/msb.
+static_assert(FieldOf<TIM1::CR1::CEN>::offset == 0, "");
+static_assert(FieldOf<TIM1::CR1::CEN>::width == 1, "");
+static_assert(FieldOf<TIM1::CR1::CMS>::offset == 5, "");
+static_assert(FieldOf<TIM1::CR1::CMS>::width == 2, "");
+static_assert(FieldOf<TIM1::CR1::CKD>::offset == 8, "");
+static_assert(FieldOf<TIM1::CR1::CKD>::width == 2, "");
+
+// Enumerated values, including a derived set. isDefault is skipped.
+static_assert(uint32_t(TIM1::CR1::CMS_t::center1) == 1, "");
+static_assert(uint32_t(TIM1::CR1::CMS_t::center3) == 3, "");
+static_assert(uint32_t(TIM1::CR1::DIR_t::center3) == 3, "");
+static_assert(std::is_same<FieldOf<TIM1::CR1::DIR>::FieldType,
+                           TIM1::CR1::DIR_t>::value,
+              "");
+
+// Access from register and field.
+static_assert(TIM1::SR::Access::readable && !TIM1::SR::Access::writable, "");
+static_assert(!TIM1::EGR::Access::readable, "");
+static_assert(DMA::CH0_CCR::EN::Access::writable, "");
+static_assert(!DMA::CH0_CCR::TCIF::Access::writable, "");
+
+// Renamed fields.
+static_assert(FieldOf<TIM1::SR::address_>::offset == 4, "");
+static_assert(FieldOf<TIM1::EGR::vint>::offset == 1, "");
+
+// dim register arrays with dimIndex, and 16 bit registers.
+static_assert(TIM1::CCR1::address() == 0x40010034u, "");
+static_assert(TIM1::CCR4::address() == 0x40010040u, "");
+static_assert(std::is_same<TIM1::CCR4::RegStorage, uint16_t>::value, "");
+
+// derivedFrom peripheral: same registers at the new base.
+static_assert(TIM2::baseAddress == 0x40000000u, "");
+static_assert(TIM2::CR1::address() == 0x40000000u, "");
+static_assert(TIM2::CCR2::address() == 0x40000038u, "");
+static_assert(uint32_t(TIM2::CR1::CMS_t::center1) == 1, "");
+
+// dim clusters.
+static_assert(DMA::CH0_CCR::address() == 0x40020008u, "");
+static_assert(DMA::CH1_CCR::address() == 0x4002001cu, "");
+static_assert(DMA::CH1_CNDTR::address() == 0x40020020u, "");
+static_assert(DMA::CH1_CNDTR::resetValue() == 0xffffu, "");
+
+} // namespace
+
+int
+main()
+{
+    // Generated fields combine into one update.
+    auto wu = bitops::set<TIM1::CR1::CEN>() %
+              bitops::value<TIM1::CR1::CMS>(TIM1::CR1::CMS_t::center3) %
+              bitops::value<TIM1::CR1::CKD>(2);
+    uint32_t cr1 = TIM1::CR1::resetValue();
+    cr1 %= wu;
+    return cr1 == 0x261u ? 0 : 1;
+}
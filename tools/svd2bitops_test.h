@@ -0,0 +1,215 @@
+// Generated by svd2bitops.py from TESTDEV. Do not edit.
+
+#pragma once
+
+#include "register.h"
+
+#include <cstdint>
+
+namespace testdev
+{
+
+// Timer
+namespace TIM1
+{
+constexpr uintptr_t baseAddress = 0x40010000u;
+
+// Control register 1
+struct CR1 : bitops::Register<uint32_t, 0x40010000u, 0x00000100u,
+                              bitops::access::ReadWrite>
+{
+    // Counter enable
+    using CEN = bitops::RegField<CR1, uint32_t, 0, 1>;
+
+    // Center aligned mode
+    enum class CMS_t : uint32_t
+    {
+        edge = 0x0u,
+        center1 = 0x1u,
+        center3 = 0x3u,
+    };
+    using CMS = bitops::RegField<CR1, CMS_t, 5, 2>;
+
+    // Clock division
+    using CKD = bitops::RegField<CR1, uint32_t, 8, 2>;
+
+    // Direction, same values as CMS
+    enum class DIR_t : uint32_t
+    {
+        edge = 0x0u,
+        center1 = 0x1u,
+        center3 = 0x3u,
+    };
+    using DIR = bitops::RegField<CR1, DIR_t, 12, 2>;
+};
+
+// Status register
+struct SR : bitops::Register<uint32_t, 0x40010010u, 0x00000000u,
+                             bitops::access::ReadOnly>
+{
+    using UIF = bitops::RegField<SR, uint32_t, 0, 1>;
+
+    // Clashes with Register::address
+    using address_ = bitops::RegField<SR, uint32_t, 4, 4>;
+};
+
+// Capture/compare register
+struct CCR1 : bitops::Register<uint16_t, 0x40010034u, 0x0000u,
+                               bitops::access::ReadWrite>
+{
+    using CCR = bitops::RegField<CCR1, uint16_t, 0, 16>;
+};
+
+// Capture/compare register
+struct CCR2 : bitops::Register<uint16_t, 0x40010038u, 0x0000u,
+                               bitops::access::ReadWrite>
+{
+    using CCR = bitops::RegField<CCR2, uint16_t, 0, 16>;
+};
+
+// Capture/compare register
+struct CCR3 : bitops::Register<uint16_t, 0x4001003cu, 0x0000u,
+                               bitops::access::ReadWrite>
+{
+    using CCR = bitops::RegField<CCR3, uint16_t, 0, 16>;
+};
+
+// Capture/compare register
+struct CCR4 : bitops::Register<uint16_t, 0x40010040u, 0x0000u,
+                               bitops::access::ReadWrite>
+{
+    using CCR = bitops::RegField<CCR4, uint16_t, 0, 16>;
+};
+
+// Event generation
+struct EGR : bitops::Register<uint32_t, 0x40010014u, 0x00000000u,
+                              bitops::access::WriteOnly>
+{
+    using UG = bitops::RegField<EGR, uint32_t, 0, 1>;
+
+    // Keyword as name
+    using vint = bitops::RegField<EGR, uint32_t, 1, 1>;
+};
+} // namespace TIM1
+
+// Timer
+namespace TIM2
+{
+constexpr uintptr_t baseAddress = 0x40000000u;
+
+// Control register 1
+struct CR1 : bitops::Register<uint32_t, 0x40000000u, 0x00000100u,
+                              bitops::access::ReadWrite>
+{
+    // Counter enable
+    using CEN = bitops::RegField<CR1, uint32_t, 0, 1>;
+
+    // Center aligned mode
+    enum class CMS_t : uint32_t
+    {
+        edge = 0x0u,
+        center1 = 0x1u,
+        center3 = 0x3u,
+    };
+    using CMS = bitops::RegField<CR1, CMS_t, 5, 2>;
+
+    // Clock division
+    using CKD = bitops::RegField<CR1, uint32_t, 8, 2>;
+
+    // Direction, same values as CMS
+    enum class DIR_t : uint32_t
+    {
+        edge = 0x0u,
+        center1 = 0x1u,
+        center3 = 0x3u,
+    };
+    using DIR = bitops::RegField<CR1, DIR_t, 12, 2>;
+};
+
+// Status register
+struct SR : bitops::Register<uint32_t, 0x40000010u, 0x00000000u,
+                             bitops::access::ReadOnly>
+{
+    using UIF = bitops::RegField<SR, uint32_t, 0, 1>;
+
+    // Clashes with Register::address
+    using address_ = bitops::RegField<SR, uint32_t, 4, 4>;
+};
+
+// Capture/compare register
+struct CCR1 : bitops::Register<uint16_t, 0x40000034u, 0x0000u,
+                               bitops::access::ReadWrite>
+{
+    using CCR = bitops::RegField<CCR1, uint16_t, 0, 16>;
+};
+
+// Capture/compare register
+struct CCR2 : bitops::Register<uint16_t, 0x40000038u, 0x0000u,
+                               bitops::access::ReadWrite>
+{
+    using CCR = bitops::RegField<CCR2, uint16_t, 0, 16>;
+};
+
+// Capture/compare register
+struct CCR3 : bitops::Register<uint16_t, 0x4000003cu, 0x0000u,
+                               bitops::access::ReadWrite>
+{
+    using CCR = bitops::RegField<CCR3, uint16_t, 0, 16>;
+};
+
+// Capture/compare register
+struct CCR4 : bitops::Register<uint16_t, 0x40000040u, 0x0000u,
+                               bitops::access::ReadWrite>
+{
+    using CCR = bitops::RegField<CCR4, uint16_t, 0, 16>;
+};
+
+// Event generation
+struct EGR : bitops::Register<uint32_t, 0x40000014u, 0x00000000u,
+                              bitops::access::WriteOnly>
+{
+    using UG = bitops::RegField<EGR, uint32_t, 0, 1>;
+
+    // Keyword as name
+    using vint = bitops::RegField<EGR, uint32_t, 1, 1>;
+};
+} // namespace TIM2
+
+// DMA controller
+namespace DMA
+{
+constexpr uintptr_t baseAddress = 0x40020000u;
+
+// Channel configuration
+struct CH0_CCR : bitops::Register<uint32_t, 0x40020008u, 0x00000000u,
+                                  bitops::access::ReadWrite>
+{
+    using EN = bitops::RegField<CH0_CCR, uint32_t, 0, 1>;
+
+    // Read only flag in a read-write register
+    using TCIF =
+        bitops::RegField<CH0_CCR, uint32_t, 1, 1, bitops::access::ReadOnly>;
+};
+
+struct CH0_CNDTR : bitops::Register<uint32_t, 0x4002000cu, 0x0000ffffu,
+                                    bitops::access::ReadWrite>
+{
+};
+
+// Channel configuration
+struct CH1_CCR : bitops::Register<uint32_t, 0x4002001cu, 0x00000000u,
+                                  bitops::access::ReadWrite>
+{
+    using EN = bitops::RegField<CH1_CCR, uint32_t, 0, 1>;
+
+    // Read only flag in a read-write register
+    using TCIF =
+        bitops::RegField<CH1_CCR, uint32_t, 1, 1, bitops::access::ReadOnly>;
+};
+
+struct CH1_CNDTR : bitops::Register<uint32_t, 0x40020020u, 0x0000ffffu,
+                                    bitops::access::ReadWrite>
+{
+};
+} // namespace DMA
+} // namespace testdev